@@ -2,11 +2,25 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <string.h>
+#include <time.h>
 
 #include "astar.h"
 #include "pool.h"
 #include "genetic.h"
 #include "config.h"
+#include "tour.h"
+#include "hpa.h"
+#include "grid.h"
+#include "genome.h"
+
+typedef enum {
+    MODE_ASTAR = 0,
+    MODE_WEIGHTED,
+    MODE_BIDIRECTIONAL,
+    MODE_ANYTIME,
+    MODE_JPS,
+    MODE_HPA
+} SearchMode;
 
 static inline int idx3(int x,int y,int z){
     return z*config.grid_x*config.grid_y + y*config.grid_x + x;
@@ -14,88 +28,688 @@ static inline int idx3(int x,int y,int z){
 static inline int manhattan(Coord a, Coord b){
     return abs(a.x-b.x)+abs(a.y-b.y)+abs(a.z-b.z);
 }
+static inline Coord cell_coord(int c){
+    int z = c/(config.grid_x*config.grid_y);
+    int rem = c%(config.grid_x*config.grid_y);
+    return (Coord){rem%config.grid_x, rem/config.grid_x, z};
+}
+
+static double now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e3 + (double)ts.tv_nsec/1e6;
+}
+
+// Per-node search state. Nodes carry the stamp of the search that last
+// touched them, so the workspace is reset by bumping w->stamp.
+typedef struct {
+    int cell;              // linear grid index
+    int g;
+    int f;
+    int came;              // slot of the parent node, -1 at the start
+    int heap_pos;          // -1 when not in the open heap
+    unsigned int stamp;
+    int closed;            // iteration that closed the node, 0 = open/new
+    unsigned char incons;  // anytime: queued for the next iteration
+    signed char dir;       // jps: direction of arrival, -1 at the start
+} ANode;
+
+// Search workspace, allocated on first use and reused by every segment.
+// Nodes are addressed by slot: in dense mode slot == cell and all cells are
+// preallocated; in sparse mode only touched cells get a slot, found through
+// an open-addressing table keyed by cell index.
+typedef struct {
+    int    sparse;
+    int    num_cells;
+
+    ANode *nodes;
+    int    nodes_len;      // sparse: slots handed out this search
+    int    nodes_cap;
+
+    int   *tab_cell;       // sparse: cell -> slot table
+    int   *tab_slot;
+    unsigned int *tab_stamp;
+    int    tab_cap;        // power of two
+
+    int   *heap;           // open list: binary min-heap of slots
+    int    heap_len;
+    int    heap_cap;
+
+    int   *incons;         // anytime: slots improved after being closed
+    int    incons_len;
+    int    incons_cap;
+
+    unsigned int stamp;
+
+    long   expanded;
+    size_t peak_bytes;
+} AStarWS;
+
+// Forward search, plus the backward half of a bidirectional search.
+static AStarWS ws_fwd, ws_bwd;
+
+static AStarSegment *seg_stats = NULL;
+static int           seg_count = 0;
+
+static void *xrealloc(void *p, size_t n){
+    p = realloc(p, n);
+    if(!p){ fprintf(stderr,"alloc failed\n"); exit(1); }
+    return p;
+}
 
-static int astar_one(Coord start, Coord goal, Coord *out, int *out_len, int max_len){
+static void ws_release(AStarWS *w){
+    free(w->nodes); free(w->heap); free(w->incons);
+    free(w->tab_cell); free(w->tab_slot); free(w->tab_stamp);
+    memset(w,0,sizeof(*w));
+}
+
+static void tab_alloc(AStarWS *w, int cap){
+    w->tab_cap   = cap;
+    w->tab_cell  = (int*)xrealloc(NULL,(size_t)cap*sizeof(int));
+    w->tab_slot  = (int*)xrealloc(NULL,(size_t)cap*sizeof(int));
+    w->tab_stamp = (unsigned int*)calloc((size_t)cap,sizeof(unsigned int));
+    if(!w->tab_stamp){ fprintf(stderr,"alloc failed\n"); exit(1); }
+}
+
+static void ws_prepare(AStarWS *w){
     int N = config.grid_x*config.grid_y*config.grid_z;
+    int sparse = (N > config.astar_sparse_threshold);
+    if(w->nodes && w->num_cells==N && w->sparse==sparse) return;
 
-    int *g = (int*)malloc((size_t)N*sizeof(int));
-    int *f = (int*)malloc((size_t)N*sizeof(int));
-    int *came = (int*)malloc((size_t)N*sizeof(int));
-    unsigned char *open = (unsigned char*)calloc((size_t)N,1);
-    unsigned char *closed = (unsigned char*)calloc((size_t)N,1);
-    if(!g||!f||!came||!open||!closed){ fprintf(stderr,"alloc failed\n"); exit(1); }
+    ws_release(w);
+    w->sparse = sparse;
+    w->num_cells = N;
+    if(sparse){
+        w->nodes_cap = 1024;
+        tab_alloc(w,2048);
+    } else {
+        w->nodes_cap = N;
+    }
+    w->nodes = (ANode*)calloc((size_t)w->nodes_cap,sizeof(ANode));
+    w->heap_cap = 1024;
+    w->heap = (int*)xrealloc(NULL,(size_t)w->heap_cap*sizeof(int));
+    w->incons_cap = 256;
+    w->incons = (int*)xrealloc(NULL,(size_t)w->incons_cap*sizeof(int));
+    if(!w->nodes){ fprintf(stderr,"alloc failed\n"); exit(1); }
+}
 
-    for(int i=0;i<N;i++){ g[i]=INT_MAX/4; f[i]=INT_MAX/4; came[i]=-1; }
+static size_t ws_bytes(const AStarWS *w){
+    if(!w->nodes) return 0;
+    size_t b = (size_t)w->nodes_cap*sizeof(ANode)
+             + (size_t)(w->heap_cap+w->incons_cap)*sizeof(int);
+    if(w->sparse) b += (size_t)w->tab_cap*(2*sizeof(int)+sizeof(unsigned int));
+    return b;
+}
 
-    int s = idx3(start.x,start.y,start.z);
-    int t = idx3(goal.x,goal.y,goal.z);
+static void ws_note_peak(AStarWS *w){
+    size_t b = ws_bytes(w);
+    if(b>w->peak_bytes) w->peak_bytes = b;
+}
 
-    g[s]=0;
-    f[s]=manhattan(start,goal);
-    open[s]=1;
+void astar_free_workspace(void){
+    ws_release(&ws_fwd);
+    ws_release(&ws_bwd);
+    hpa_free();
+    free(seg_stats);
+    seg_stats = NULL;
+    seg_count = 0;
+}
+
+static void ws_begin_search(AStarWS *w){
+    w->heap_len = 0;
+    w->nodes_len = 0;
+    w->incons_len = 0;
+    if(++w->stamp==0){
+        // wrapped: old stamps could alias the new search
+        for(int i=0;i<w->nodes_cap;i++) w->nodes[i].stamp=0;
+        for(int i=0;i<w->tab_cap;i++) w->tab_stamp[i]=0;
+        w->stamp = 1;
+    }
+}
+
+static void node_reset(AStarWS *w, int slot, int cell){
+    ANode *n = &w->nodes[slot];
+    n->cell = cell;
+    n->stamp = w->stamp;
+    n->g = INT_MAX/4;
+    n->f = INT_MAX/4;
+    n->came = -1;
+    n->heap_pos = -1;
+    n->closed = 0;
+    n->incons = 0;
+    n->dir = -1;
+}
+
+static inline unsigned int tab_hash(int cell){
+    return (unsigned int)cell * 2654435761u;
+}
 
-    Coord dirs[6]={{1,0,0},{-1,0,0},{0,1,0},{0,-1,0},{0,0,1},{0,0,-1}};
+static void tab_grow(AStarWS *w){
+    int old_cap = w->tab_cap;
+    int *old_cell = w->tab_cell, *old_slot = w->tab_slot;
+    unsigned int *old_stamp = w->tab_stamp;
 
+    tab_alloc(w,old_cap*2);
+    for(int i=0;i<old_cap;i++){
+        if(old_stamp[i]!=w->stamp) continue;
+        unsigned int h = tab_hash(old_cell[i]) & (unsigned int)(w->tab_cap-1);
+        while(w->tab_stamp[h]==w->stamp) h = (h+1) & (unsigned int)(w->tab_cap-1);
+        w->tab_cell[h] = old_cell[i];
+        w->tab_slot[h] = old_slot[i];
+        w->tab_stamp[h] = w->stamp;
+    }
+    free(old_cell); free(old_slot); free(old_stamp);
+}
+
+// Slot for a cell if this search has touched it, else -1.
+static int node_find(const AStarWS *w, int cell){
+    if(!w->sparse) return (w->nodes[cell].stamp==w->stamp) ? cell : -1;
+
+    unsigned int mask = (unsigned int)(w->tab_cap-1);
+    unsigned int h = tab_hash(cell) & mask;
+    while(w->tab_stamp[h]==w->stamp){
+        if(w->tab_cell[h]==cell) return w->tab_slot[h];
+        h = (h+1) & mask;
+    }
+    return -1;
+}
+
+// Slot for a cell, creating a fresh node if this search has not seen it.
+static int node_slot(AStarWS *w, int cell){
+    if(!w->sparse){
+        if(w->nodes[cell].stamp!=w->stamp) node_reset(w,cell,cell);
+        return cell;
+    }
+
+    if(2*(w->nodes_len+1) > w->tab_cap) tab_grow(w);
+    unsigned int mask = (unsigned int)(w->tab_cap-1);
+    unsigned int h = tab_hash(cell) & mask;
+    while(w->tab_stamp[h]==w->stamp){
+        if(w->tab_cell[h]==cell) return w->tab_slot[h];
+        h = (h+1) & mask;
+    }
+
+    if(w->nodes_len==w->nodes_cap){
+        w->nodes_cap *= 2;
+        w->nodes = (ANode*)xrealloc(w->nodes,(size_t)w->nodes_cap*sizeof(ANode));
+    }
+    int slot = w->nodes_len++;
+    node_reset(w,slot,cell);
+    w->tab_cell[h] = cell;
+    w->tab_slot[h] = slot;
+    w->tab_stamp[h] = w->stamp;
+
+    ws_note_peak(w);
+    return slot;
+}
+
+// Heap order is (f, cell index): the same node the old linear scan over
+// all cells picked, so paths are unchanged and dense/sparse agree.
+static inline int heap_less(const AStarWS *w, int a, int b){
+    const ANode *na = &w->nodes[a], *nb = &w->nodes[b];
+    return na->f<nb->f || (na->f==nb->f && na->cell<nb->cell);
+}
+
+static void heap_set(AStarWS *w, int pos, int i){
+    w->heap[pos] = i;
+    w->nodes[i].heap_pos = pos;
+}
+
+static void heap_sift_up(AStarWS *w, int pos){
+    int i = w->heap[pos];
+    while(pos>0){
+        int parent = (pos-1)/2;
+        if(!heap_less(w, i, w->heap[parent])) break;
+        heap_set(w, pos, w->heap[parent]);
+        pos = parent;
+    }
+    heap_set(w, pos, i);
+}
+
+static void heap_sift_down(AStarWS *w, int pos){
+    int i = w->heap[pos];
     while(1){
-        int cur=-1;
-        int bestf=INT_MAX;
-        for(int i=0;i<N;i++){
-            if(open[i] && f[i]<bestf){ bestf=f[i]; cur=i; }
+        int c = 2*pos+1;
+        if(c>=w->heap_len) break;
+        if(c+1<w->heap_len && heap_less(w, w->heap[c+1], w->heap[c])) c++;
+        if(!heap_less(w, w->heap[c], i)) break;
+        heap_set(w, pos, w->heap[c]);
+        pos = c;
+    }
+    heap_set(w, pos, i);
+}
+
+// Insert, or restore heap order after the node's f decreased.
+static void heap_push_or_decrease(AStarWS *w, int i){
+    ANode *n = &w->nodes[i];
+    if(n->heap_pos>=0){ heap_sift_up(w, n->heap_pos); return; }
+
+    if(w->heap_len==w->heap_cap){
+        w->heap_cap *= 2;
+        w->heap = (int*)xrealloc(w->heap,(size_t)w->heap_cap*sizeof(int));
+        ws_note_peak(w);
+    }
+    w->heap[w->heap_len] = i;
+    n->heap_pos = w->heap_len++;
+    heap_sift_up(w, n->heap_pos);
+}
+
+static int heap_pop(AStarWS *w){
+    int top = w->heap[0];
+    w->nodes[top].heap_pos = -1;
+    w->heap_len--;
+    if(w->heap_len>0){
+        heap_set(w, 0, w->heap[w->heap_len]);
+        heap_sift_down(w, 0);
+    }
+    return top;
+}
+
+static inline int heap_top_f(const AStarWS *w){
+    return w->heap_len>0 ? w->nodes[w->heap[0]].f : INT_MAX/4;
+}
+
+static inline int weighted_h(int h, double eps){
+    return (eps<=1.0) ? h : (int)(eps*(double)h);
+}
+
+// Walk parents from `slot` back to the search root, writing cells root-first.
+// If truncated it keeps the first max_len cells, so the result still starts
+// at the root and can be appended to the path built so far.
+static int trace_back(const AStarWS *w, int slot, Coord *out, int max_len){
+    int total=0;
+    for(int x=slot;x!=-1;x=w->nodes[x].came) total++;
+    int count = (total<max_len) ? total : max_len;
+    int i=total;
+    for(int x=slot;x!=-1;x=w->nodes[x].came)
+        if(--i<count) out[i] = cell_coord(w->nodes[x].cell);
+    return count;
+}
+
+static const Coord dirs[6]={{1,0,0},{-1,0,0},{0,1,0},{0,-1,0},{0,0,1},{0,0,-1}};
+
+// A* (eps == 1) or weighted A* (eps > 1, paths within eps of optimal).
+static int search_weighted(Coord start, Coord goal, double eps, Coord *out, int *out_len, int max_len, long *expanded){
+    AStarWS *w = &ws_fwd;
+    ws_prepare(w);
+    ws_begin_search(w);
+
+    int t = idx3(goal.x,goal.y,goal.z);
+
+    int s = node_slot(w, idx3(start.x,start.y,start.z));
+    w->nodes[s].g = 0;
+    w->nodes[s].f = weighted_h(manhattan(start,goal), eps);
+    heap_push_or_decrease(w, s);
+
+    while(w->heap_len>0){
+        int cur = heap_pop(w);
+
+        if(w->nodes[cur].cell==t){
+            *out_len = trace_back(w, cur, out, max_len);
+            return 1;
         }
-        if(cur==-1) break;
-
-        if(cur==t){
-            int count=0;
-            int x=cur;
-            while(x!=-1 && count<max_len){
-                int z = x/(config.grid_x*config.grid_y);
-                int rem = x%(config.grid_x*config.grid_y);
-                int y = rem/config.grid_x;
-                int xx = rem%config.grid_x;
-                out[count++] = (Coord){xx,y,z};
-                x = came[x];
+
+        w->nodes[cur].closed = 1;
+        w->expanded++;
+        (*expanded)++;
+
+        Coord c = cell_coord(w->nodes[cur].cell);
+        for(int d=0;d<6;d++){
+            Coord nb={c.x+dirs[d].x, c.y+dirs[d].y, c.z+dirs[d].z};
+            if(!grid_free(nb)) continue;
+
+            // node_slot may move w->nodes in sparse mode: index, don't hold pointers
+            int ni = node_slot(w, idx3(nb.x,nb.y,nb.z));
+            if(w->nodes[ni].closed) continue;
+
+            int tentative = w->nodes[cur].g+1;
+            if(w->nodes[ni].heap_pos<0 || tentative < w->nodes[ni].g){
+                w->nodes[ni].came = cur;
+                w->nodes[ni].g = tentative;
+                w->nodes[ni].f = tentative + weighted_h(manhattan(nb,goal), eps);
+                heap_push_or_decrease(w, ni);
             }
-            for(int i=0;i<count/2;i++){
-                Coord tmp=out[i];
-                out[i]=out[count-1-i];
-                out[count-1-i]=tmp;
+        }
+    }
+
+    return 0;
+}
+
+// Expand one node of a bidirectional search; `other` is the opposite
+// direction, used to close the meeting cost mu.
+static void bidir_expand(AStarWS *w, AStarWS *other, Coord target, int *mu, int *meet){
+    int cur = heap_pop(w);
+    w->nodes[cur].closed = 1;
+    w->expanded++;
+
+    Coord c = cell_coord(w->nodes[cur].cell);
+    for(int d=0;d<6;d++){
+        Coord nb={c.x+dirs[d].x, c.y+dirs[d].y, c.z+dirs[d].z};
+        if(!grid_free(nb)) continue;
+
+        int cell = idx3(nb.x,nb.y,nb.z);
+        int ni = node_slot(w, cell);
+        int tentative = w->nodes[cur].g+1;
+        if(w->nodes[ni].closed || (w->nodes[ni].heap_pos>=0 && tentative>=w->nodes[ni].g)) continue;
+
+        w->nodes[ni].came = cur;
+        w->nodes[ni].g = tentative;
+        w->nodes[ni].f = tentative + manhattan(nb,target);
+        heap_push_or_decrease(w, ni);
+
+        int oi = node_find(other, cell);
+        if(oi>=0 && tentative + other->nodes[oi].g < *mu){
+            *mu = tentative + other->nodes[oi].g;
+            *meet = cell;
+        }
+    }
+}
+
+// Bidirectional A*: forward from start and backward from goal, expanding
+// the smaller frontier; stops once either frontier cannot beat mu.
+static int search_bidirectional(Coord start, Coord goal, Coord *out, int *out_len, int max_len, long *expanded){
+    AStarWS *f = &ws_fwd, *b = &ws_bwd;
+    ws_prepare(f); ws_prepare(b);
+    ws_begin_search(f); ws_begin_search(b);
+
+    int sc = idx3(start.x,start.y,start.z);
+    int tc = idx3(goal.x,goal.y,goal.z);
+    long e0 = f->expanded + b->expanded;
+
+    int s = node_slot(f, sc);
+    f->nodes[s].g = 0;
+    f->nodes[s].f = manhattan(start,goal);
+    heap_push_or_decrease(f, s);
+
+    int t = node_slot(b, tc);
+    b->nodes[t].g = 0;
+    b->nodes[t].f = manhattan(start,goal);
+    heap_push_or_decrease(b, t);
+
+    int mu = (sc==tc) ? 0 : INT_MAX/4;
+    int meet = (sc==tc) ? sc : -1;
+
+    while(f->heap_len>0 && b->heap_len>0){
+        if(heap_top_f(f)>=mu || heap_top_f(b)>=mu) break;
+        if(f->heap_len<=b->heap_len) bidir_expand(f, b, goal, &mu, &meet);
+        else                         bidir_expand(b, f, start, &mu, &meet);
+    }
+    *expanded += f->expanded + b->expanded - e0;
+
+    if(meet<0) return 0;
+
+    // start..meet from the forward tree, then meet..goal from the backward one
+    int count = trace_back(f, node_find(f, meet), out, max_len);
+    int x = b->nodes[node_find(b, meet)].came;
+    while(x!=-1 && count<max_len){
+        out[count++] = cell_coord(b->nodes[x].cell);
+        x = b->nodes[x].came;
+    }
+    *out_len = count;
+    return 1;
+}
+
+// ARA*: weighted A* with a falling eps that reuses g-values between
+// iterations. Each finished iteration publishes a path into `out`; the
+// search stops after the eps == 1 iteration or at the deadline, once it has
+// a first solution.
+static int search_anytime(Coord start, Coord goal, double deadline, Coord *out, int *out_len, int max_len,
+                          long *expanded, int *improvements){
+    AStarWS *w = &ws_fwd;
+    ws_prepare(w);
+    ws_begin_search(w);
+
+    int t = idx3(goal.x,goal.y,goal.z);
+    double eps = config.astar_epsilon;
+    int iter = 1;
+    int found = 0;
+
+    int s = node_slot(w, idx3(start.x,start.y,start.z));
+    w->nodes[s].g = 0;
+    w->nodes[s].f = weighted_h(manhattan(start,goal), eps);
+    heap_push_or_decrease(w, s);
+
+    while(1){
+        int tg_slot = node_find(w, t);
+        int timed_out = 0;
+
+        // ImprovePath: expand while some open node could still beat g(goal)
+        while(w->heap_len>0){
+            tg_slot = node_find(w, t);
+            int goal_g = (tg_slot>=0) ? w->nodes[tg_slot].g : INT_MAX/4;
+            if(goal_g <= heap_top_f(w)) break;
+
+            if(found && (w->expanded & 255)==0 && now_ms()>=deadline){ timed_out=1; break; }
+
+            int cur = heap_pop(w);
+            w->nodes[cur].closed = iter;
+            w->expanded++;
+            (*expanded)++;
+
+            Coord c = cell_coord(w->nodes[cur].cell);
+            for(int d=0;d<6;d++){
+                Coord nb={c.x+dirs[d].x, c.y+dirs[d].y, c.z+dirs[d].z};
+                if(!grid_free(nb)) continue;
+
+                int ni = node_slot(w, idx3(nb.x,nb.y,nb.z));
+                int tentative = w->nodes[cur].g+1;
+                if(tentative >= w->nodes[ni].g) continue;
+
+                w->nodes[ni].came = cur;
+                w->nodes[ni].g = tentative;
+                w->nodes[ni].f = tentative + weighted_h(manhattan(nb,goal), eps);
+                if(w->nodes[ni].closed!=iter){
+                    heap_push_or_decrease(w, ni);
+                } else if(!w->nodes[ni].incons){
+                    w->nodes[ni].incons = 1;
+                    if(w->incons_len==w->incons_cap){
+                        w->incons_cap *= 2;
+                        w->incons = (int*)xrealloc(w->incons,(size_t)w->incons_cap*sizeof(int));
+                        ws_note_peak(w);
+                    }
+                    w->incons[w->incons_len++] = ni;
+                }
+            }
+        }
+
+        if(timed_out) break;
+
+        tg_slot = node_find(w, t);
+        if(tg_slot<0 || w->nodes[tg_slot].g>=INT_MAX/4) break; // unreachable
+        int len = trace_back(w, tg_slot, out, max_len);
+        if(!found || len<*out_len){ *out_len = len; (*improvements)++; }
+        found = 1;
+
+        if(eps<=1.0 || now_ms()>=deadline) break;
+
+        // next iteration: lower eps, fold INCONS back into OPEN and re-key it
+        eps -= config.astar_epsilon_step;
+        if(eps<1.0) eps = 1.0;
+        iter++;
+        for(int i=0;i<w->incons_len;i++){
+            int ni = w->incons[i];
+            w->nodes[ni].incons = 0;
+            if(w->nodes[ni].heap_pos<0){
+                w->heap[w->heap_len] = ni;
+                w->nodes[ni].heap_pos = w->heap_len++;
             }
-            *out_len=count;
+        }
+        w->incons_len = 0;
+        for(int i=0;i<w->heap_len;i++){
+            ANode *n = &w->nodes[w->heap[i]];
+            n->f = n->g + weighted_h(manhattan(cell_coord(n->cell),goal), eps);
+        }
+        for(int i=w->heap_len/2-1;i>=0;i--) heap_sift_down(w, i);
+    }
+
+    return found;
+}
 
-            free(g);free(f);free(came);free(open);free(closed);
+// Jump point search. Directions are numbered as in dirs[]: axis = d>>1,
+// and axes have priority x > y > z. The canonical path between two cells
+// moves along x first, then y, then z, so a node entered along axis a only
+// continues along a or turns onto a lower-priority axis; a turn back onto a
+// higher-priority axis is needed only where the cell beside the parent
+// blocked that canonical route (a forced neighbour).
+static inline Coord step(Coord c, int d){
+    return (Coord){c.x+dirs[d].x, c.y+dirs[d].y, c.z+dirs[d].z};
+}
+
+// Direction e (on a higher-priority axis than d) is forced at n, entered along d.
+static inline int jps_forced(Coord n, int d, int e){
+    Coord p = {n.x-dirs[d].x, n.y-dirs[d].y, n.z-dirs[d].z};
+    return grid_free(step(n,e)) && !grid_free(step(p,e));
+}
+
+static int jps_has_forced(Coord n, int d){
+    for(int e=0;e<(d&~1);e++) if(jps_forced(n,d,e)) return 1;
+    return 0;
+}
+
+// Walk from c along d; the first jump point, or 0 if the line hits a wall.
+static int jps_jump(Coord c, int d, Coord goal, Coord *out){
+    while(1){
+        Coord n = step(c,d);
+        if(!grid_free(n)) return 0;
+        if((n.x==goal.x && n.y==goal.y && n.z==goal.z) || jps_has_forced(n,d)){
+            *out = n;
             return 1;
         }
+        Coord tmp;
+        for(int e=(d|1)+1;e<6;e++){
+            if(jps_jump(n,e,goal,&tmp)){ *out = n; return 1; }
+        }
+        c = n;
+    }
+}
+
+// Parents are jump points, so the straight runs between them are filled in.
+// g is the exact cell distance, which places every cell without a first pass.
+static int jps_trace_back(const AStarWS *w, int slot, Coord *out, int max_len){
+    int total = w->nodes[slot].g + 1;
+    int count = (total<max_len) ? total : max_len;
+    int i = total;
+    for(int x=slot;x!=-1;x=w->nodes[x].came){
+        Coord c = cell_coord(w->nodes[x].cell);
+        int p = w->nodes[x].came;
+        if(--i<count) out[i] = c;
+        if(p==-1) break;
+        Coord pc = cell_coord(w->nodes[p].cell);
+        int d = w->nodes[x].dir;
+        for(;;){
+            c = (Coord){c.x-dirs[d].x, c.y-dirs[d].y, c.z-dirs[d].z};
+            if(c.x==pc.x && c.y==pc.y && c.z==pc.z) break;
+            if(--i<count) out[i] = c;
+        }
+    }
+    return count;
+}
+
+static int search_jps(Coord start, Coord goal, Coord *out, int *out_len, int max_len, long *expanded){
+    AStarWS *w = &ws_fwd;
+    ws_prepare(w);
+    ws_begin_search(w);
+
+    int t = idx3(goal.x,goal.y,goal.z);
 
-        open[cur]=0;
-        closed[cur]=1;
+    int s = node_slot(w, idx3(start.x,start.y,start.z));
+    w->nodes[s].g = 0;
+    w->nodes[s].f = manhattan(start,goal);
+    heap_push_or_decrease(w, s);
 
-        int cz = cur/(config.grid_x*config.grid_y);
-        int rem = cur%(config.grid_x*config.grid_y);
-        int cy = rem/config.grid_x;
-        int cx = rem%config.grid_x;
+    while(w->heap_len>0){
+        int cur = heap_pop(w);
 
+        if(w->nodes[cur].cell==t){
+            *out_len = jps_trace_back(w, cur, out, max_len);
+            return 1;
+        }
+
+        w->nodes[cur].closed = 1;
+        w->expanded++;
+        (*expanded)++;
+
+        Coord c = cell_coord(w->nodes[cur].cell);
+        int din = w->nodes[cur].dir;
         for(int d=0;d<6;d++){
-            Coord nb={cx+dirs[d].x, cy+dirs[d].y, cz+dirs[d].z};
-            if(!is_valid(nb)) continue;
-            if(get_cell(nb)==OBSTACLE) continue;
-
-            int ni = idx3(nb.x,nb.y,nb.z);
-            if(closed[ni]) continue;
-
-            int tentative = g[cur]+1;
-            if(!open[ni] || tentative < g[ni]){
-                came[ni]=cur;
-                g[ni]=tentative;
-                f[ni]=tentative + manhattan(nb,goal);
-                open[ni]=1;
+            if(din>=0){
+                if(d==(din^1)) continue;
+                // natural: straight on, or onto a lower-priority axis
+                if(d!=din && d<(din|1) && !jps_forced(c,din,d)) continue;
+            }
+
+            Coord jp;
+            if(!jps_jump(c,d,goal,&jp)) continue;
+
+            int ni = node_slot(w, idx3(jp.x,jp.y,jp.z));
+            if(w->nodes[ni].closed) continue;
+
+            int tentative = w->nodes[cur].g + manhattan(c,jp);
+            if(w->nodes[ni].heap_pos<0 || tentative < w->nodes[ni].g){
+                w->nodes[ni].came = cur;
+                w->nodes[ni].dir = (signed char)d;
+                w->nodes[ni].g = tentative;
+                w->nodes[ni].f = tentative + manhattan(jp,goal);
+                heap_push_or_decrease(w, ni);
             }
         }
     }
 
-    free(g);free(f);free(came);free(open);free(closed);
     return 0;
 }
 
+static SearchMode parse_mode(void){
+    if(strcmp(config.astar_mode,"weighted")==0)      return MODE_WEIGHTED;
+    if(strcmp(config.astar_mode,"bidirectional")==0) return MODE_BIDIRECTIONAL;
+    if(strcmp(config.astar_mode,"anytime")==0)       return MODE_ANYTIME;
+    if(strcmp(config.astar_mode,"jps")==0)           return MODE_JPS;
+    if(strcmp(config.astar_mode,"hpa")==0)           return MODE_HPA;
+    return MODE_ASTAR;
+}
+
+int astar_one(Coord start, Coord goal, Coord *out, int *out_len, int max_len,
+              double deadline, AStarSegment *seg){
+    double t0 = now_ms();
+    int ok = 0;
+
+    switch(parse_mode()){
+    case MODE_WEIGHTED:
+        ok = search_weighted(start, goal, config.astar_epsilon, out, out_len, max_len, &seg->expanded);
+        break;
+    case MODE_BIDIRECTIONAL:
+        ok = search_bidirectional(start, goal, out, out_len, max_len, &seg->expanded);
+        break;
+    case MODE_ANYTIME:
+        ok = search_anytime(start, goal, deadline, out, out_len, max_len, &seg->expanded, &seg->improvements);
+        break;
+    case MODE_JPS:
+        ok = search_jps(start, goal, out, out_len, max_len, &seg->expanded);
+        break;
+    case MODE_HPA:
+        ok = hpa_search(start, goal, out, out_len, max_len, &seg->expanded);
+        ws_fwd.expanded += seg->expanded;
+        break;
+    default:
+        ok = search_weighted(start, goal, 1.0, out, out_len, max_len, &seg->expanded);
+        break;
+    }
+
+    seg->found = ok;
+    seg->length = ok ? *out_len : 0;
+    seg->ms = now_ms() - t0;
+    return ok;
+}
+
+void astar_get_stats(AStarStats *out){
+    out->sparse = ws_fwd.sparse;
+    out->expanded = ws_fwd.expanded + ws_bwd.expanded;
+    out->peak_node_bytes = ws_fwd.sparse ? ws_fwd.peak_bytes + ws_bwd.peak_bytes
+                                         : ws_bytes(&ws_fwd) + ws_bytes(&ws_bwd);
+    out->mode = config.astar_mode;
+    out->num_segments = seg_count;
+    out->segments = seg_stats;
+}
+
 static void sort_survivors_by_priority(int *order){
     for(int i=0;i<config.num_survivors;i++) order[i]=i;
 
@@ -109,16 +723,12 @@ static void sort_survivors_by_priority(int *order){
     }
 }
 
-int astar_build_baseline(Path *out_path, Coord start){
-    out_path->length=0;
-    out_path->fitness=0;
-    out_path->survivors_reached=0;
-    out_path->priority_sum=0;
-    out_path->coverage=0;
+int astar_build_baseline(Path *out_path, Coord start, FitnessScratch *s){
+    if(strcmp(config.baseline_order,"tour")==0) return tour_build_baseline(out_path, start, s);
 
+    genome_reset(out_path, start);
     if(config.num_survivors==0){
-        out_path->genes[out_path->length++]=start;
-        calculate_fitness(out_path);
+        calculate_fitness(out_path, s);
         return 1;
     }
 
@@ -126,23 +736,36 @@ int astar_build_baseline(Path *out_path, Coord start){
     if(!order) exit(1);
     sort_survivors_by_priority(order);
 
+    free(seg_stats);
+    seg_stats = (AStarSegment*)calloc((size_t)config.num_survivors,sizeof(AStarSegment));
+    if(!seg_stats) exit(1);
+    seg_count = 0;
+
     Coord current=start;
-    out_path->genes[out_path->length++]=current;
 
-    Coord *tmp = (Coord*)malloc((size_t)MAX_PATH_LENGTH*sizeof(Coord));
+    Coord *tmp = (Coord*)malloc((size_t)out_path->cap*sizeof(Coord));
     if(!tmp) exit(1);
 
+    // anytime mode splits what is left of the deadline over the remaining legs
+    double t_end = now_ms() + (double)config.astar_deadline_ms;
+
     for(int k=0;k<config.num_survivors;k++){
         Coord goal = shared->survivors[ order[k] ];
         int seg_len=0;
 
-        if(!astar_one(current, goal, tmp, &seg_len, MAX_PATH_LENGTH)) {
+        double now = now_ms();
+        double deadline = now + (t_end-now)/(double)(config.num_survivors-k);
+
+        AStarSegment *seg = &seg_stats[seg_count++];
+        seg->survivor = order[k];
+        // a leg only needs what is left of the path
+        int room = out_path->cap - out_path->length + 1;
+        if(!astar_one(current, goal, tmp, &seg_len, room, deadline, seg)) {
             continue; // unreachable -> skip
         }
 
-        for(int i=1;i<seg_len && out_path->length<MAX_PATH_LENGTH;i++){
-            out_path->genes[out_path->length++] = tmp[i];
-        }
+        for(int i=1;i<seg_len;i++) genome_append(out_path, tmp[i-1], tmp[i]);
+        if(out_path->length>=out_path->cap) break; // full
 
         current = goal;
     }
@@ -150,6 +773,6 @@ int astar_build_baseline(Path *out_path, Coord start){
     free(order);
     free(tmp);
 
-    calculate_fitness(out_path);
+    calculate_fitness(out_path, s);
     return (out_path->length>0);
 }
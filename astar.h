@@ -2,9 +2,45 @@
 #define ASTAR_H
 
 #include "types.h"
+#include "genetic.h"
 
 // A* baseline for comparison only: visits survivors in descending priority order.
+// config.astar_mode picks the search per leg: astar, weighted (f = g + eps*h),
+// bidirectional, anytime (ARA*, improves until astar_deadline_ms), jps (jump
+// point search) or hpa (hierarchical, see hpa.h).
+// With baseline_order=tour the order and legs come from tour_build_baseline.
 // Returns 1 if builds a (possibly partial) path, 0 if none.
-int astar_build_baseline(Path *out_path, Coord start);
+int astar_build_baseline(Path *out_path, Coord start, FitnessScratch *s);
+
+// One baseline leg (current position -> next survivor).
+typedef struct {
+    int    survivor;          // index into shared->survivors
+    int    found;
+    int    length;            // cells in the leg, including both ends
+    long   expanded;          // nodes expanded for this leg
+    int    improvements;      // anytime: solutions published
+    double ms;
+} AStarSegment;
+
+typedef struct {
+    int    sparse;            // node storage used by the searches
+    long   expanded;          // nodes expanded since the workspace was created
+    size_t peak_node_bytes;   // high-water mark of search node memory
+
+    const char         *mode; // config.astar_mode
+    int                 num_segments;
+    const AStarSegment *segments;
+} AStarStats;
+
+void astar_get_stats(AStarStats *out);
+
+// One leg with config.astar_mode, as the baseline runs it: up to max_len
+// cells into out, their count in *out_len. anytime stops at deadline
+// (CLOCK_MONOTONIC ms). Returns 1 if the goal was reached.
+int astar_one(Coord start, Coord goal, Coord *out, int *out_len, int max_len,
+              double deadline, AStarSegment *seg);
+
+// The search workspace persists across calls; release it when done.
+void astar_free_workspace(void);
 
 #endif
@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+"""Fixed-seed macro benchmarks for rescue_robot.
+
+  bench.py run [--out bench_results.json] [--repeat 3] [--max-workers N] [--quick]
+  bench.py compare BASELINE RESULTS [--tolerance 0.15]
+  bench.py stop [--runs 60] [--timeout 20]
+
+run writes one JSON document: every scenario at 4 workers on the processes
+backend, then the scaling scenario on both backends for 1..max-workers.
+Timings are medians over --repeat runs; peak RSS is the main process's
+high-water mark plus that of the largest worker. compare matches runs by
+(scenario, backend, workers) and exits 1 if any got slower, used more
+memory or found a different best path than the baseline.
+
+stop repeats short deadline_ms runs on both backends, with the deadline
+swept so it lands at different points of a GENS_PER_BARRIER block, and
+exits 1 if any run fails to finish within --timeout seconds (a stop
+request must release every worker, wherever it is) or did not print its
+deadline result before joining the workers.
+"""
+import argparse, json, os, platform, re, statistics, subprocess, sys, tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+BINARY = os.path.join(HERE, "rescue_robot")
+
+# Shared by every scenario; no early stop, so each run does the same work.
+COMMON = dict(seed=1, start_mode=3, stagnation_limit=0, time_limit_seconds=0,
+              snapshot_format="binary", w1=25, w2=3, w3=0.2, w4=2,
+              missing_priority_penalty=1000, full_rescue_bonus=5000)
+
+# target: a fitness the GA reaches part way through the run (time-to-target)
+SCENARIOS = [
+    dict(name="tiny_10x10x3", grid_x=10, grid_y=10, grid_z=3, num_survivors=7, num_obstacles=10,
+         population_size=40, num_generations=400, max_path_length=100, target_fitness=-3000),
+    dict(name="dense_30x30x8", grid_x=30, grid_y=30, grid_z=8, num_survivors=10, num_obstacles=2000,
+         population_size=200, num_generations=200, max_path_length=200, target_fitness=-9100),
+    dict(name="medium_100x100x10", grid_x=100, grid_y=100, grid_z=10, num_survivors=20, num_obstacles=10000,
+         population_size=200, num_generations=100, max_path_length=400, target_fitness=-18500),
+    dict(name="sparse_200x200x20", grid_x=200, grid_y=200, grid_z=20, num_survivors=30, num_obstacles=8000,
+         population_size=100, num_generations=50, max_path_length=800, target_fitness=-27800),
+    dict(name="large_500x500x20", grid_x=500, grid_y=500, grid_z=20, num_survivors=40, num_obstacles=250000,
+         population_size=100, num_generations=25, max_path_length=1000, target_fitness=-38990),
+]
+SCALING = "dense_30x30x8"
+WORKERS = 4
+
+# config.c may reduce counts that do not fit the grid, so the effective
+# values are read back from the program's settings printout
+PATTERNS = {
+    "survivors":      (r"^Survivors: (\d+)", int),
+    "obstacles":      (r"^Obstacles: (\d+)", int),
+    "astar_s":        (r"^A\* time: ([0-9.]+) sec", float),
+    "ga_s":           (r"^GA time: ([0-9.]+) sec", float),
+    "best_fitness":   (r"^Best fitness: (-?[0-9.]+)", float),
+    "evals":          (r"^Fitness evaluations: (\d+)", int),
+    "gens_per_sec":   (r"^Throughput .*: ([0-9.]+) generations/sec", float),
+    "children_per_sec": (r"^Throughput .*\| ([0-9.]+) children/sec", float),
+    "time_to_target_s": (r"^Time to target fitness .*: ([0-9.]+) sec", float),
+    "main_rss_kb":    (r"^Peak RSS: (?:main )?(\d+) KB", int),
+    "worker_rss_kb":  (r"^Peak RSS: main \d+ KB \| largest worker (\d+) KB", int),
+}
+TIMED = ("astar_s", "ga_s", "gens_per_sec", "children_per_sec", "time_to_target_s")
+
+
+def run_once(cfg, workdir):
+    path = os.path.join(workdir, "bench.txt")
+    with open(path, "w") as f:
+        for k, v in cfg.items():
+            if k != "name":
+                f.write(f"{k}={v}\n")
+    p = subprocess.run([BINARY, path], cwd=workdir, stdin=subprocess.DEVNULL,
+                       stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    out = p.stdout
+    if p.returncode != 0:
+        sys.exit(f"{cfg['name']}: rescue_robot exited with {p.returncode}\n{out[-2000:]}")
+
+    r = {}
+    for key, (pat, conv) in PATTERNS.items():
+        m = re.search(pat, out, re.M)
+        r[key] = conv(m.group(1)) if m else None
+    m = re.search(r"^Grid: (\d+)x(\d+)x(\d+)$", out, re.M)
+    r["grid"] = [int(g) for g in m.groups()] if m else None
+    return r
+
+
+def run_scenario(sc, backend, workers, repeat, workdir):
+    cfg = dict(COMMON, **sc, backend=backend, num_processes=workers)
+    runs = [run_once(cfg, workdir) for _ in range(repeat)]
+    res = {"scenario": sc["name"], "backend": backend, "workers": workers, "grid": runs[0]["grid"]}
+    asked = ([sc["grid_x"], sc["grid_y"], sc["grid_z"]], sc["num_survivors"], sc["num_obstacles"])
+    if (res["grid"], runs[0]["survivors"], runs[0]["obstacles"]) != asked:
+        print(f"  {sc['name']}: runs as {res['grid']}, {runs[0]['survivors']} survivors, "
+              f"{runs[0]['obstacles']} obstacles, not as configured")
+    for key in PATTERNS:
+        vals = [r[key] for r in runs if r[key] is not None]
+        if key in TIMED:
+            res[key] = statistics.median(vals) if vals else None
+        else:
+            res[key] = runs[0][key]
+    # main plus the largest worker (shared memory counts in both)
+    res["peak_rss_kb"] = max((r["main_rss_kb"] or 0) + (r["worker_rss_kb"] or 0) for r in runs)
+    print(f"  {res['scenario']:<20} {backend:<10} {workers:>2}w  children/s {res['children_per_sec'] or 0:>10.0f}"
+          f"  A* {res['astar_s']:.4f}s  GA {res['ga_s']:.3f}s  target "
+          f"{'%.3fs' % res['time_to_target_s'] if res['time_to_target_s'] is not None else '-':>7}"
+          f"  RSS {res['peak_rss_kb'] / 1024:.1f} MB", flush=True)
+    return res
+
+
+def cmd_run(args):
+    if not os.path.exists(BINARY):
+        sys.exit(f"{BINARY} not built")
+    scenarios = SCENARIOS[:3] if args.quick else SCENARIOS
+    results = {"meta": {"machine": platform.machine(), "cpus": os.cpu_count(),
+                        "repeat": args.repeat, "seed": COMMON["seed"]},
+               "runs": []}
+    with tempfile.TemporaryDirectory() as workdir:
+        print("scenarios:")
+        for sc in scenarios:
+            results["runs"].append(run_scenario(sc, "processes", WORKERS, args.repeat, workdir))
+        print(f"scaling ({SCALING}):")
+        sc = next(s for s in SCENARIOS if s["name"] == SCALING)
+        for n in range(1, args.max_workers + 1):
+            for backend in ("processes", "threads"):
+                if n == WORKERS and backend == "processes":
+                    continue  # already run above
+                results["runs"].append(run_scenario(sc, backend, n, args.repeat, workdir))
+    with open(args.out, "w") as f:
+        json.dump(results, f, indent=1)
+    print(f"wrote {args.out}")
+
+
+# metric -> direction in which a change is a regression
+CHECKS = {"children_per_sec": "lower", "astar_s": "higher",
+          "ga_s": "higher", "time_to_target_s": "higher", "peak_rss_kb": "higher"}
+# ignore timing differences below these, they are scheduler noise
+FLOOR = {"astar_s": 0.005, "ga_s": 0.02, "time_to_target_s": 0.02}
+
+
+def cmd_compare(args):
+    base = {(r["scenario"], r["backend"], r["workers"]): r for r in json.load(open(args.baseline))["runs"]}
+    cur = json.load(open(args.results))["runs"]
+    bad = 0
+    for r in cur:
+        key = (r["scenario"], r["backend"], r["workers"])
+        b = base.get(key)
+        if b is None:
+            print(f"new   {key}")
+            continue
+        notes = []
+        for m, worse in CHECKS.items():
+            old, new = b.get(m), r.get(m)
+            if old is None or new is None:
+                if (old is None) != (new is None):
+                    notes.append(f"{m} {old} -> {new}")
+                    bad += 1
+                continue
+            if abs(new - old) < FLOOR.get(m, 0):
+                continue
+            change = (new - old) / old if old else 0
+            if (worse == "lower" and change < -args.tolerance) or (worse == "higher" and change > args.tolerance):
+                notes.append(f"{m} {old:g} -> {new:g} ({change:+.1%})")
+                bad += 1
+        if b.get("best_fitness") != r.get("best_fitness"):
+            notes.append(f"best_fitness {b.get('best_fitness')} -> {r.get('best_fitness')} (results changed)")
+            bad += 1
+        print(f"{'FAIL' if notes else 'ok':<5} {key[0]} {key[1]} {key[2]}w" + ("".join("\n      " + n for n in notes)))
+    for key in base.keys() - {(r["scenario"], r["backend"], r["workers"]) for r in cur}:
+        print(f"gone  {key}")
+    print(f"{bad} regression(s) beyond {args.tolerance:.0%}")
+    return 1 if bad else 0
+
+
+# Blocks of a few ms each, so most deadlines fall while workers are breeding.
+STOP = dict(COMMON, grid_x=30, grid_y=30, grid_z=8, num_survivors=10, num_obstacles=300,
+            population_size=400, num_generations=100000, max_path_length=200)
+
+
+def cmd_stop(args):
+    if not os.path.exists(BINARY):
+        sys.exit(f"{BINARY} not built")
+    bad = 0
+    with tempfile.TemporaryDirectory() as workdir:
+        path = os.path.join(workdir, "stop.txt")
+        for i in range(args.runs):
+            cfg = dict(STOP, name="stop", seed=1 + i, num_processes=2 + i % 3, deadline_ms=5 + 7 * i % 60,
+                       backend="threads" if i % 4 == 3 else "processes")
+            with open(path, "w") as f:
+                for k, v in cfg.items():
+                    if k != "name":
+                        f.write(f"{k}={v}\n")
+            p = subprocess.Popen([BINARY, path], cwd=workdir, stdin=subprocess.DEVNULL,
+                                 stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True,
+                                 start_new_session=True)
+            try:
+                out, _ = p.communicate(timeout=args.timeout)
+                ok = p.returncode == 0
+                note = "" if ok else f"exit {p.returncode}"
+            except subprocess.TimeoutExpired:
+                os.killpg(p.pid, 9)  # the workers too
+                out, _ = p.communicate()
+                ok, note = False, f"hung past {args.timeout}s"
+            # the result comes before the join, so even a hung run has it
+            res, fin = out.find("Deadline result:"), out.find("=== Final GA Results")
+            if res < 0 or (fin >= 0 and fin < res):
+                ok, note = False, (note + ", " if note else "") + "no deadline result before the join"
+            if not ok:
+                bad += 1
+                print(f"FAIL  run {i}: {cfg['backend']} {cfg['num_processes']} workers, "
+                      f"deadline_ms={cfg['deadline_ms']}: {note}")
+        print(f"{args.runs - bad}/{args.runs} stopped cleanly")
+    return 1 if bad else 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    r = sub.add_parser("run")
+    r.add_argument("--out", default="bench_results.json")
+    r.add_argument("--repeat", type=int, default=3)
+    r.add_argument("--max-workers", type=int, default=os.cpu_count() or 1)
+    r.add_argument("--quick", action="store_true", help="skip the two largest grids")
+    c = sub.add_parser("compare")
+    c.add_argument("baseline")
+    c.add_argument("results")
+    c.add_argument("--tolerance", type=float, default=0.15)
+    s = sub.add_parser("stop")
+    s.add_argument("--runs", type=int, default=60)
+    s.add_argument("--timeout", type=float, default=20)
+    args = ap.parse_args()
+    if args.cmd == "stop":
+        return cmd_stop(args)
+    if args.cmd == "run":
+        cmd_run(args)
+        return 0
+    return cmd_compare(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -2,9 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 #include <unistd.h>
 
 #include "config.h"
+#include "pool.h"
 
 Config config;
 
@@ -39,6 +41,9 @@ void set_default_config(void) {
     config.max_path_length = 100;
 
     config.num_processes = 0; // auto
+    strcpy(config.backend, "processes");
+    strcpy(config.ga_mode, "generational");
+    strcpy(config.steady_replace, "worst");
 
     config.num_survivors = 7;
     config.num_obstacles = 10;
@@ -53,8 +58,21 @@ void set_default_config(void) {
     config.crossover_rate  = 0.80;
     config.tournament_size = 3;
 
+    config.seed = 0;
+
+    config.migration_interval = 0;
+    config.migration_count    = 2;
+    strcpy(config.migration_topology, "ring");
+    strcpy(config.migration_replace, "worst");
+    config.target_fitness = 0;
+    config.target_set     = 0;
+    config.start_mode     = 0;
+
     config.stagnation_limit   = 50;
     config.time_limit_seconds = 0;
+    config.deadline_ms        = 0;
+    strcpy(config.snapshot_format, "text");
+    config.telemetry_file[0] = '\0';
 
     config.survivor_priorities_csv[0] = '\0';
     config.priority_default = 1;
@@ -62,6 +80,23 @@ void set_default_config(void) {
     // crucial: make "missing survivors" dominate fitness
     config.missing_priority_penalty = 1000.0;
     config.full_rescue_bonus        = 5000.0;
+
+    strcpy(config.grid_storage, "dense");
+
+    strcpy(config.fitness_kernel, "auto");
+    config.fitness_cache_size = 4096;
+
+    config.astar_sparse_threshold = 4000000;
+    strcpy(config.astar_mode, "astar");
+    config.astar_epsilon      = 2.0;
+    config.astar_epsilon_step = 0.5;
+    config.astar_deadline_ms  = 1000;
+    config.hpa_cluster        = 16;
+
+    strcpy(config.baseline_order, "priority");
+    config.tour_priority_weight = 1.0;
+    config.tour_exact_limit     = 12;
+    config.tour_field_mb        = 512;
 }
 
 int read_config(const char *filename) {
@@ -92,6 +127,35 @@ int read_config(const char *filename) {
             else if (strcmp(key, "max_path_length") == 0) config.max_path_length = atoi(val);
 
             else if (strcmp(key, "num_processes") == 0) config.num_processes = atoi(val);
+            else if (strcmp(key, "backend") == 0) {
+                strncpy(config.backend, val, sizeof(config.backend)-1);
+                config.backend[sizeof(config.backend)-1] = '\0';
+            }
+            else if (strcmp(key, "ga_mode") == 0) {
+                strncpy(config.ga_mode, val, sizeof(config.ga_mode)-1);
+                config.ga_mode[sizeof(config.ga_mode)-1] = '\0';
+            }
+            else if (strcmp(key, "steady_replace") == 0) {
+                strncpy(config.steady_replace, val, sizeof(config.steady_replace)-1);
+                config.steady_replace[sizeof(config.steady_replace)-1] = '\0';
+            }
+            else if (strcmp(key, "seed") == 0) config.seed = strtoull(val, NULL, 10);
+
+            else if (strcmp(key, "migration_interval") == 0) config.migration_interval = atoi(val);
+            else if (strcmp(key, "migration_count") == 0) config.migration_count = atoi(val);
+            else if (strcmp(key, "migration_topology") == 0) {
+                strncpy(config.migration_topology, val, sizeof(config.migration_topology)-1);
+                config.migration_topology[sizeof(config.migration_topology)-1] = '\0';
+            }
+            else if (strcmp(key, "migration_replace") == 0) {
+                strncpy(config.migration_replace, val, sizeof(config.migration_replace)-1);
+                config.migration_replace[sizeof(config.migration_replace)-1] = '\0';
+            }
+            else if (strcmp(key, "target_fitness") == 0) {
+                config.target_fitness = atof(val);
+                config.target_set = (strcmp(val, "baseline") == 0) ? 2 : 1;
+            }
+            else if (strcmp(key, "start_mode") == 0) config.start_mode = atoi(val);
 
             else if (strcmp(key, "num_survivors") == 0) config.num_survivors = atoi(val);
             else if (strcmp(key, "num_obstacles") == 0) config.num_obstacles = atoi(val);
@@ -108,6 +172,15 @@ int read_config(const char *filename) {
 
             else if (strcmp(key, "stagnation_limit") == 0) config.stagnation_limit = atoi(val);
             else if (strcmp(key, "time_limit_seconds") == 0) config.time_limit_seconds = atoi(val);
+            else if (strcmp(key, "deadline_ms") == 0) config.deadline_ms = atoi(val);
+            else if (strcmp(key, "telemetry_file") == 0) {
+                strncpy(config.telemetry_file, val, sizeof(config.telemetry_file)-1);
+                config.telemetry_file[sizeof(config.telemetry_file)-1] = '\0';
+            }
+            else if (strcmp(key, "snapshot_format") == 0) {
+                strncpy(config.snapshot_format, val, sizeof(config.snapshot_format)-1);
+                config.snapshot_format[sizeof(config.snapshot_format)-1] = '\0';
+            }
 
             else if (strcmp(key, "survivor_priorities") == 0) {
                 strncpy(config.survivor_priorities_csv, val, sizeof(config.survivor_priorities_csv)-1);
@@ -117,36 +190,106 @@ int read_config(const char *filename) {
 
             else if (strcmp(key, "missing_priority_penalty") == 0) config.missing_priority_penalty = atof(val);
             else if (strcmp(key, "full_rescue_bonus") == 0) config.full_rescue_bonus = atof(val);
+
+            else if (strcmp(key, "grid_storage") == 0) {
+                strncpy(config.grid_storage, val, sizeof(config.grid_storage)-1);
+                config.grid_storage[sizeof(config.grid_storage)-1] = '\0';
+            }
+            else if (strcmp(key, "fitness_kernel") == 0) {
+                strncpy(config.fitness_kernel, val, sizeof(config.fitness_kernel)-1);
+                config.fitness_kernel[sizeof(config.fitness_kernel)-1] = '\0';
+            }
+            else if (strcmp(key, "fitness_cache_size") == 0) config.fitness_cache_size = atoi(val);
+
+            else if (strcmp(key, "astar_sparse_threshold") == 0) config.astar_sparse_threshold = atoi(val);
+            else if (strcmp(key, "astar_mode") == 0) {
+                strncpy(config.astar_mode, val, sizeof(config.astar_mode)-1);
+                config.astar_mode[sizeof(config.astar_mode)-1] = '\0';
+            }
+            else if (strcmp(key, "astar_epsilon") == 0) config.astar_epsilon = atof(val);
+            else if (strcmp(key, "astar_epsilon_step") == 0) config.astar_epsilon_step = atof(val);
+            else if (strcmp(key, "astar_deadline_ms") == 0) config.astar_deadline_ms = atoi(val);
+            else if (strcmp(key, "hpa_cluster") == 0) config.hpa_cluster = atoi(val);
+
+            else if (strcmp(key, "baseline_order") == 0) {
+                strncpy(config.baseline_order, val, sizeof(config.baseline_order)-1);
+                config.baseline_order[sizeof(config.baseline_order)-1] = '\0';
+            }
+            else if (strcmp(key, "tour_priority_weight") == 0) config.tour_priority_weight = atof(val);
+            else if (strcmp(key, "tour_exact_limit") == 0) config.tour_exact_limit = atoi(val);
+            else if (strcmp(key, "tour_field_mb") == 0) config.tour_field_mb = atoi(val);
         }
         fclose(f);
     }
 
     // sanitize
-    config.grid_x = clamp_int(config.grid_x, 1, 500);
-    config.grid_y = clamp_int(config.grid_y, 1, 500);
-    config.grid_z = clamp_int(config.grid_z, 1, 500);
+    config.grid_x = clamp_int(config.grid_x, 1, 2000);
+    config.grid_y = clamp_int(config.grid_y, 1, 2000);
+    config.grid_z = clamp_int(config.grid_z, 1, 2000);
+    // cells are addressed with int indices
+    if ((long)config.grid_x * config.grid_y * config.grid_z > INT_MAX) {
+        config.grid_z = INT_MAX / (config.grid_x * config.grid_y);
+        fprintf(stderr, "⚠️  Warning: grid too large, grid_z reduced to %d\n", config.grid_z);
+    }
+    if (strcmp(config.grid_storage, "chunked") != 0) strcpy(config.grid_storage, "dense");
+    if (strcmp(config.backend, "threads") != 0) strcpy(config.backend, "processes");
+    if (strcmp(config.ga_mode, "steady") != 0) strcpy(config.ga_mode, "generational");
+    if (strcmp(config.ga_mode, "steady") == 0 && strcmp(config.backend, "threads") == 0) {
+        fprintf(stderr, "⚠️  Warning: ga_mode=steady needs backend=processes, using generational\n");
+        strcpy(config.ga_mode, "generational");
+    }
+    if (strcmp(config.steady_replace, "tournament") != 0) strcpy(config.steady_replace, "worst");
+    if (strcmp(config.snapshot_format, "binary") != 0) strcpy(config.snapshot_format, "text");
+    if (strcmp(config.migration_topology, "torus") != 0 && strcmp(config.migration_topology, "full") != 0)
+        strcpy(config.migration_topology, "ring");
+    if (strcmp(config.migration_replace, "random") != 0) strcpy(config.migration_replace, "worst");
 
     config.population_size = clamp_int(config.population_size, 2, 100000);
     config.num_generations = clamp_int(config.num_generations, 1, 1000000);
 
     config.max_path_length = clamp_int(config.max_path_length, 1, 100000);
 
-    config.num_survivors = clamp_int(config.num_survivors, 0, 100000);
-    config.num_obstacles = clamp_int(config.num_obstacles, 0, 100000);
+    // obstacles and survivors are placed on free cells by rejection, so
+    // leave at least one cell over for the start
+    int cells = config.grid_x * config.grid_y * config.grid_z;
+    int req_survivors = config.num_survivors, req_obstacles = config.num_obstacles;
+    config.num_survivors = clamp_int(config.num_survivors, 0, (cells - 1 < 100000) ? cells - 1 : 100000);
+    config.num_obstacles = clamp_int(config.num_obstacles, 0, cells - 1 - config.num_survivors);
+    if (config.num_survivors != req_survivors)
+        fprintf(stderr, "⚠️  Warning: num_survivors=%d does not fit the grid, using %d\n", req_survivors, config.num_survivors);
+    if (config.num_obstacles != req_obstacles)
+        fprintf(stderr, "⚠️  Warning: num_obstacles=%d does not fit the grid, using %d\n", req_obstacles, config.num_obstacles);
 
     config.elitism_percent = clamp_double(config.elitism_percent, 0.0, 0.95);
     config.mutation_rate   = clamp_double(config.mutation_rate, 0.0, 1.0);
     config.crossover_rate  = clamp_double(config.crossover_rate, 0.0, 1.0);
     config.tournament_size = clamp_int(config.tournament_size, 2, 50);
 
+    config.migration_interval = clamp_int(config.migration_interval, 0, 1000000);
+    config.migration_count    = clamp_int(config.migration_count, 1, 1000);
+    config.start_mode         = clamp_int(config.start_mode, 0, 3);
+
     config.stagnation_limit   = clamp_int(config.stagnation_limit, 0, 1000000);
     config.time_limit_seconds = clamp_int(config.time_limit_seconds, 0, 1000000);
+    config.deadline_ms        = clamp_int(config.deadline_ms, 0, 86400000);
 
     config.priority_default = clamp_int(config.priority_default, 1, 1000000);
 
     config.missing_priority_penalty = clamp_double(config.missing_priority_penalty, 0.0, 1e9);
     config.full_rescue_bonus        = clamp_double(config.full_rescue_bonus, 0.0, 1e9);
 
+    config.fitness_cache_size = clamp_int(config.fitness_cache_size, 0, 1 << 24);
+
+    if (config.astar_sparse_threshold < 0) config.astar_sparse_threshold = 0;
+    config.astar_epsilon      = clamp_double(config.astar_epsilon, 1.0, 100.0);
+    config.astar_epsilon_step = clamp_double(config.astar_epsilon_step, 0.01, 100.0);
+    config.astar_deadline_ms  = clamp_int(config.astar_deadline_ms, 0, 86400000);
+    config.hpa_cluster        = clamp_int(config.hpa_cluster, 4, 64);
+
+    config.tour_priority_weight = clamp_double(config.tour_priority_weight, 0.0, 1e6);
+    config.tour_exact_limit     = clamp_int(config.tour_exact_limit, 0, 20);
+    config.tour_field_mb        = clamp_int(config.tour_field_mb, 0, 1 << 20);
+
     // auto processes if 0
     if (config.num_processes <= 0) {
         long cores = sysconf(_SC_NPROCESSORS_ONLN);
@@ -168,7 +311,12 @@ void print_config(void) {
     printf("Population: %d\n", config.population_size);
     printf("Generations: %d\n", config.num_generations);
     printf("Max path length: %d\n", config.max_path_length);
-    printf("Processes: %d\n", config.num_processes);
+    printf("Workers: %d (%s)\n", config.num_processes, config.backend);
+    if (strcmp(config.ga_mode, "steady") == 0)
+        printf("GA mode: steady (replace %s, budget %ld evaluations)\n", config.steady_replace,
+               (long)config.num_generations * GENS_PER_BARRIER * config.population_size);
+    else
+        printf("GA mode: generational\n");
     printf("Survivors: %d\n", config.num_survivors);
     printf("Obstacles: %d\n", config.num_obstacles);
 
@@ -178,8 +326,20 @@ void print_config(void) {
     printf("GA params: elitism=%.2f mutation=%.2f crossover=%.2f tournament=%d\n",
            config.elitism_percent, config.mutation_rate, config.crossover_rate, config.tournament_size);
 
-    printf("Stopping: stagnation_limit=%d time_limit_seconds=%d\n",
-           config.stagnation_limit, config.time_limit_seconds);
+    printf("Seed: %llu%s\n", config.seed, config.seed ? "" : " (from the clock)");
+    if (config.migration_interval > 0)
+        printf("Migration: every %d generations, %d paths, %s topology, replace %s\n",
+               config.migration_interval, config.migration_count,
+               config.migration_topology, config.migration_replace);
+    else
+        printf("Migration: off\n");
+    if (config.target_set == 2) printf("Target fitness: the A* baseline's\n");
+    else if (config.target_set) printf("Target fitness: %.2f\n", config.target_fitness);
+
+    printf("Stopping: stagnation_limit=%d time_limit_seconds=%d deadline_ms=%d\n",
+           config.stagnation_limit, config.time_limit_seconds, config.deadline_ms);
+    printf("Snapshots: %s\n", config.snapshot_format);
+    printf("Telemetry: %s\n", config.telemetry_file[0] ? config.telemetry_file : "off");
 
     if (config.survivor_priorities_csv[0]) {
         printf("Survivor priorities (csv): %s\n", config.survivor_priorities_csv);
@@ -190,5 +350,13 @@ void print_config(void) {
     printf("Missing priority penalty=%.2f | Full rescue bonus=%.2f\n",
            config.missing_priority_penalty, config.full_rescue_bonus);
 
+    printf("Grid storage: %s\n", config.grid_storage);
+    printf("Fitness kernel: %s | cache entries: %d\n", config.fitness_kernel, config.fitness_cache_size);
+    printf("A* mode: %s (eps=%.2f step=%.2f deadline=%d ms hpa cluster=%d) | sparse above %d cells\n",
+           config.astar_mode, config.astar_epsilon, config.astar_epsilon_step,
+           config.astar_deadline_ms, config.hpa_cluster, config.astar_sparse_threshold);
+    printf("Baseline order: %s (tour weight=%.2f exact<=%d fields=%d MB)\n",
+           config.baseline_order, config.tour_priority_weight, config.tour_exact_limit, config.tour_field_mb);
+
     printf("=====================\n\n");
 }
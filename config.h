@@ -8,7 +8,10 @@ typedef struct {
     int num_generations;
     int max_path_length;
 
-    int num_processes; // 0 = auto
+    int num_processes; // 0 = auto; worker threads with backend=threads
+    char backend[16];  // processes (fork, private sub-populations) | threads (one population)
+    char ga_mode[16];  // generational | steady (processes only: no barriers, budget in evaluations)
+    char steady_replace[16];  // steady: worst | tournament (loser of a tournament_size draw)
 
     int num_survivors;
     int num_obstacles;
@@ -20,8 +23,20 @@ typedef struct {
     double crossover_rate;
     int tournament_size;
 
+    unsigned long long seed;  // 0 = from the clock (printed, so the run can be replayed)
+
+    int  migration_interval;        // local generations between migrations, 0 disables
+    int  migration_count;           // paths sent along each edge per migration
+    char migration_topology[16];    // ring | torus | full
+    char migration_replace[16];     // worst | random (never the island's best)
+    double target_fitness;          // report time to reach it
+    int    target_set;              // target_fitness given: 1 = a value, 2 = "baseline" (the A* baseline's fitness)
+
+    int  start_mode;                // 1 top | 2 edges | 3 random; 0 asks on stdin
+
     int stagnation_limit;     // 0 disables
     int time_limit_seconds;   // 0 disables
+    int deadline_ms;          // anytime: stop and take the best this long after the GA starts, 0 disables
 
     char survivor_priorities_csv[512]; // optional: "5,4,3,..."
     int priority_default;              // default priority if list missing
@@ -29,6 +44,26 @@ typedef struct {
     // NEW: penalty weights to force rescuing survivors dominates fitness
     double missing_priority_penalty;   // e.g., 1000.0
     double full_rescue_bonus;          // e.g., 5000.0
+
+    char grid_storage[16];             // dense | chunked (16^3 bricks, empty chunks free)
+
+    char fitness_kernel[16];           // auto | avx2 | sse4 | scalar
+    int  fitness_cache_size;           // memoised genomes per worker, 0 disables
+
+    char snapshot_format[16];          // text (robot_data_N.txt) | binary (one appended robot_data.snap)
+    char telemetry_file[256];          // JSON lines per worker per generation, empty disables
+
+    int  astar_sparse_threshold;       // grids with more cells use sparse A* nodes
+    char astar_mode[16];               // astar | weighted | bidirectional | anytime | jps | hpa
+    double astar_epsilon;              // heuristic weight (weighted, anytime start)
+    double astar_epsilon_step;         // anytime: eps decrease per iteration
+    int  astar_deadline_ms;            // anytime: budget for the whole baseline
+    int  hpa_cluster;                  // hpa: cluster edge length in cells
+
+    char baseline_order[16];           // priority | tour
+    double tour_priority_weight;       // tour: pull high priorities forward
+    int  tour_exact_limit;             // tour: Held-Karp up to this many survivors
+    int  tour_field_mb;                // tour: memory for BFS parent fields
 } Config;
 
 extern Config config;
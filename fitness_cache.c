@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fitness_cache.h"
+#include "genome.h"
+
+#define PRIME1 0x9E3779B185EBCA87ULL
+#define PRIME2 0xC2B2AE3D27D4EB4FULL
+#define PRIME3 0x165667B19E3779F9ULL
+
+static inline unsigned long long rotl64(unsigned long long v, int r) {
+    return (v << r) | (v >> (64 - r));
+}
+
+// xxHash64-style: one round for the start cell, then one per word of
+// packed moves; bits past the last move are masked off.
+static inline unsigned long long hash_round(unsigned long long h, unsigned long long v) {
+    h ^= rotl64(v * PRIME2, 31) * PRIME1;
+    return rotl64(h, 27) * PRIME1 + PRIME3;
+}
+
+unsigned long long genome_hash(const Path *p) {
+    unsigned long long h = PRIME3 ^ ((unsigned long long)p->length * PRIME1);
+    h = hash_round(h, (unsigned long long)(unsigned int)p->start.x |
+                      ((unsigned long long)(unsigned int)p->start.y << 21) |
+                      ((unsigned long long)(unsigned int)p->start.z << 42));
+    int moves = p->length - 1;
+    for (int i = 0; i * GENOME_MOVES_PER_WORD < moves; i++) {
+        unsigned long long v = p->moves[i];
+        int left = moves - i * GENOME_MOVES_PER_WORD;
+        if (left < GENOME_MOVES_PER_WORD) v &= (1ULL << (3 * left)) - 1;
+        h = hash_round(h, v);
+    }
+    h ^= h >> 33; h *= PRIME2;
+    h ^= h >> 29; h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+void cache_init(FitnessCache *c, int entries) {
+    c->slots = NULL;
+    c->hand = NULL;
+    c->num_sets = 0;
+    c->hits = c->misses = c->evictions = 0;
+    if (entries <= 0) return;
+
+    int sets = 1;
+    while (sets * CACHE_WAYS < entries) sets <<= 1;
+
+    c->slots = (CacheEntry *)calloc((size_t)sets * CACHE_WAYS, sizeof(CacheEntry));
+    c->hand = (unsigned char *)calloc((size_t)sets, 1);
+    if (!c->slots || !c->hand) { fprintf(stderr, "alloc failed\n"); exit(1); }
+    c->num_sets = sets;
+}
+
+void cache_free(FitnessCache *c) {
+    free(c->slots);
+    free(c->hand);
+    c->slots = NULL;
+    c->hand = NULL;
+    c->num_sets = 0;
+}
+
+int cache_lookup(FitnessCache *c, unsigned long long key, Path *p) {
+    CacheEntry *set = &c->slots[(key & (unsigned long long)(c->num_sets - 1)) * CACHE_WAYS];
+    for (int w = 0; w < CACHE_WAYS; w++) {
+        CacheEntry *e = &set[w];
+        if (e->length == p->length && e->key == key) {
+            e->ref = 1;
+            p->fitness           = e->fitness;
+            p->survivors_reached = e->survivors;
+            p->priority_sum      = e->priority;
+            p->coverage          = e->coverage;
+            c->hits++;
+            return 1;
+        }
+    }
+    c->misses++;
+    return 0;
+}
+
+void cache_insert(FitnessCache *c, unsigned long long key, const Path *p) {
+    size_t s = (size_t)(key & (unsigned long long)(c->num_sets - 1));
+    CacheEntry *set = &c->slots[s * CACHE_WAYS];
+
+    CacheEntry *victim = NULL;
+    for (int w = 0; w < CACHE_WAYS; w++)
+        if (set[w].length == 0) { victim = &set[w]; break; }
+
+    if (!victim) {
+        // clock: clear reference bits until an unreferenced way comes round
+        while (set[c->hand[s]].ref) {
+            set[c->hand[s]].ref = 0;
+            c->hand[s] = (unsigned char)((c->hand[s] + 1) % CACHE_WAYS);
+        }
+        victim = &set[c->hand[s]];
+        c->hand[s] = (unsigned char)((c->hand[s] + 1) % CACHE_WAYS);
+        c->evictions++;
+    }
+
+    victim->key       = key;
+    victim->length    = p->length;
+    victim->fitness   = p->fitness;
+    victim->survivors = p->survivors_reached;
+    victim->priority  = p->priority_sum;
+    victim->coverage  = p->coverage;
+    victim->ref       = 0;
+}
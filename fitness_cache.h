@@ -0,0 +1,40 @@
+#ifndef FITNESS_CACHE_H
+#define FITNESS_CACHE_H
+
+#include "types.h"
+
+#define CACHE_WAYS 4
+
+// Memoised fitness of whole genomes, keyed by a 64-bit genome hash.
+// Set-associative with a clock (second-chance) hand per set, so memory is
+// fixed at init and no tombstones are needed.
+typedef struct {
+    unsigned long long key;
+    int    length;        // 0 = empty slot
+    double fitness;
+    int    survivors;
+    int    priority;
+    int    coverage;
+    unsigned char ref;
+} CacheEntry;
+
+typedef struct {
+    CacheEntry    *slots;    // num_sets * CACHE_WAYS
+    unsigned char *hand;     // per-set clock hand
+    int  num_sets;           // power of two, 0 = disabled
+
+    long hits;
+    long misses;
+    long evictions;
+} FitnessCache;
+
+void cache_init(FitnessCache *c, int entries);
+void cache_free(FitnessCache *c);
+
+unsigned long long genome_hash(const Path *p);
+
+// On a hit copies fitness and stats into p and returns 1.
+int  cache_lookup(FitnessCache *c, unsigned long long key, Path *p);
+void cache_insert(FitnessCache *c, unsigned long long key, const Path *p);
+
+#endif
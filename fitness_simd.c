@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "fitness_simd.h"
+#include "pool.h"
+#include "config.h"
+#include "grid.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#endif
+
+typedef void (*KernelFn)(const int*, const int*, const int*, int, int*, int*);
+
+static KernelFn    kernel_impl  = NULL;
+static const char *kernel_label = "scalar";
+
+static void kernel_scalar(const int *x, const int *y, const int *z, int n, int *lin, int *risk) {
+    int gx = config.grid_x, gy = config.grid_y, gz = config.grid_z;
+    int gxy = gx * gy;
+    for (int i = 0; i < n; i++) {
+        if (x[i] < 0 || x[i] >= gx || y[i] < 0 || y[i] >= gy || z[i] < 0 || z[i] >= gz) {
+            lin[i] = -1; risk[i] = 0;
+            continue;
+        }
+        if (grid_obstacle(x[i], y[i], z[i])) {
+            lin[i] = -1; risk[i] = 0;
+            continue;
+        }
+        lin[i]  = z[i] * gxy + y[i] * gx + x[i];
+        risk[i] = grid_risk(x[i], y[i], z[i]);
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+
+// 8 genes per step. Each lane gathers its nine 3-bit obstacle windows
+// (4-byte gathers at byte offsets; grid_obstacle_bytes pads for them),
+// packs them into 27 bits and counts them with a SWAR popcount. The centre
+// window's middle bit is the cell's own obstacle bit.
+__attribute__((target("avx2")))
+static void kernel_avx2(const int *x, const int *y, const int *z, int n, int *lin, int *risk) {
+    const __m256i neg1  = _mm256_set1_epi32(-1);
+    const __m256i one   = _mm256_set1_epi32(1);
+    const __m256i seven = _mm256_set1_epi32(7);
+    const __m256i vgx   = _mm256_set1_epi32(config.grid_x);
+    const __m256i vgy   = _mm256_set1_epi32(config.grid_y);
+    const __m256i vgz   = _mm256_set1_epi32(config.grid_z);
+    const __m256i vgxy  = _mm256_set1_epi32(config.grid_x * config.grid_y);
+    const __m256i vrows = _mm256_set1_epi32(config.grid_y + 2);
+    const __m256i vrb   = _mm256_set1_epi32(grid_row_bytes());
+    const int     rb    = grid_row_bytes();
+    const int     zs    = (config.grid_y + 2) * rb;
+    const int    *bits  = (const int *)shared->obstacle_bits;
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i X = _mm256_loadu_si256((const __m256i *)(x + i));
+        __m256i Y = _mm256_loadu_si256((const __m256i *)(y + i));
+        __m256i Z = _mm256_loadu_si256((const __m256i *)(z + i));
+
+        __m256i in = _mm256_and_si256(_mm256_cmpgt_epi32(X, neg1), _mm256_cmpgt_epi32(vgx, X));
+        in = _mm256_and_si256(in, _mm256_and_si256(_mm256_cmpgt_epi32(Y, neg1), _mm256_cmpgt_epi32(vgy, Y)));
+        in = _mm256_and_si256(in, _mm256_and_si256(_mm256_cmpgt_epi32(Z, neg1), _mm256_cmpgt_epi32(vgz, Z)));
+
+        // out-of-range lanes look at cell (0,0,0) harmlessly
+        X = _mm256_and_si256(X, in);
+        Y = _mm256_and_si256(Y, in);
+        Z = _mm256_and_si256(Z, in);
+
+        __m256i L = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(Z, vgxy),
+                                                      _mm256_mullo_epi32(Y, vgx)), X);
+
+        __m256i row = _mm256_mullo_epi32(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(Z, one), vrows),
+                                                          _mm256_add_epi32(Y, one)), vrb);
+        __m256i base  = _mm256_add_epi32(row, _mm256_srli_epi32(X, 3));
+        __m256i shift = _mm256_and_si256(X, seven);
+
+        __m256i acc = _mm256_setzero_si256();
+        for (int dz = -1; dz <= 1; dz++)
+            for (int dy = -1; dy <= 1; dy++) {
+                __m256i off = _mm256_add_epi32(base, _mm256_set1_epi32(dz * zs + dy * rb));
+                __m256i v = _mm256_i32gather_epi32(bits, off, 1);
+                v = _mm256_and_si256(_mm256_srlv_epi32(v, shift), seven);
+                acc = _mm256_or_si256(_mm256_slli_epi32(acc, 3), v);
+            }
+
+        __m256i self = _mm256_and_si256(_mm256_srli_epi32(acc, 13), one);
+        __m256i ok   = _mm256_andnot_si256(_mm256_cmpeq_epi32(self, one), in);
+
+        __m256i c = _mm256_sub_epi32(acc, _mm256_and_si256(_mm256_srli_epi32(acc, 1), _mm256_set1_epi32(0x55555555)));
+        c = _mm256_add_epi32(_mm256_and_si256(c, _mm256_set1_epi32(0x33333333)),
+                             _mm256_and_si256(_mm256_srli_epi32(c, 2), _mm256_set1_epi32(0x33333333)));
+        c = _mm256_and_si256(_mm256_add_epi32(c, _mm256_srli_epi32(c, 4)), _mm256_set1_epi32(0x0F0F0F0F));
+        c = _mm256_srli_epi32(_mm256_mullo_epi32(c, _mm256_set1_epi32(0x01010101)), 24);
+
+        _mm256_storeu_si256((__m256i *)(lin + i), _mm256_blendv_epi8(neg1, L, ok));
+        _mm256_storeu_si256((__m256i *)(risk + i), _mm256_and_si256(c, ok));
+    }
+    kernel_scalar(x + i, y + i, z + i, n - i, lin + i, risk + i);
+}
+
+// No gathers before AVX2: bounds and indices are vectorised, bitset reads are not.
+__attribute__((target("sse4.1")))
+static void kernel_sse4(const int *x, const int *y, const int *z, int n, int *lin, int *risk) {
+    const __m128i neg1 = _mm_set1_epi32(-1);
+    const __m128i vgx  = _mm_set1_epi32(config.grid_x);
+    const __m128i vgy  = _mm_set1_epi32(config.grid_y);
+    const __m128i vgz  = _mm_set1_epi32(config.grid_z);
+    const __m128i vgxy = _mm_set1_epi32(config.grid_x * config.grid_y);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i X = _mm_loadu_si128((const __m128i *)(x + i));
+        __m128i Y = _mm_loadu_si128((const __m128i *)(y + i));
+        __m128i Z = _mm_loadu_si128((const __m128i *)(z + i));
+
+        __m128i in = _mm_and_si128(_mm_cmpgt_epi32(X, neg1), _mm_cmpgt_epi32(vgx, X));
+        in = _mm_and_si128(in, _mm_and_si128(_mm_cmpgt_epi32(Y, neg1), _mm_cmpgt_epi32(vgy, Y)));
+        in = _mm_and_si128(in, _mm_and_si128(_mm_cmpgt_epi32(Z, neg1), _mm_cmpgt_epi32(vgz, Z)));
+
+        __m128i L = _mm_add_epi32(_mm_add_epi32(_mm_mullo_epi32(Z, vgxy), _mm_mullo_epi32(Y, vgx)), X);
+        L = _mm_blendv_epi8(neg1, L, in);
+        _mm_storeu_si128((__m128i *)(lin + i), L);
+
+        for (int k = 0; k < 4; k++) {
+            int j = i + k;
+            if (lin[j] < 0 || grid_obstacle(x[j], y[j], z[j])) { lin[j] = -1; risk[j] = 0; }
+            else risk[j] = grid_risk(x[j], y[j], z[j]);
+        }
+    }
+    kernel_scalar(x + i, y + i, z + i, n - i, lin + i, risk + i);
+}
+
+#endif
+
+static void pick_kernel(void) {
+    const char *want = config.fitness_kernel;
+    int any = (want[0] == '\0' || strcmp(want, "auto") == 0);
+
+    kernel_impl  = kernel_scalar;
+    kernel_label = "scalar";
+
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    // the AVX2 gathers read the dense obstacle rows directly
+    if (!shared->chunked && (any || strcmp(want, "avx2") == 0) && __builtin_cpu_supports("avx2")) {
+        kernel_impl = kernel_avx2; kernel_label = "avx2";
+    } else if ((any || strcmp(want, "sse4") == 0) && __builtin_cpu_supports("sse4.1")) {
+        kernel_impl = kernel_sse4; kernel_label = "sse4";
+    }
+#endif
+
+    if (!any && strcmp(want, kernel_label) != 0)
+        fprintf(stderr, "⚠️  Warning: fitness_kernel '%s' unavailable, using %s\n", want, kernel_label);
+}
+
+void fitness_kernel(const int *x, const int *y, const int *z, int n, int *lin, int *risk) {
+    if (!kernel_impl) pick_kernel();
+    kernel_impl(x, y, z, n, lin, risk);
+}
+
+const char *fitness_kernel_name(void) {
+    if (!kernel_impl) pick_kernel();
+    return kernel_label;
+}
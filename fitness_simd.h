@@ -0,0 +1,12 @@
+#ifndef FITNESS_SIMD_H
+#define FITNESS_SIMD_H
+
+// Per-gene part of calculate_fitness over SoA coordinates: for each gene
+// writes its linear grid index (-1 if out of bounds or an obstacle) and the
+// number of obstacles around it (grid_risk, 0 when invalid). The implementation (avx2, sse4, scalar)
+// is picked on first use from CPUID and config.fitness_kernel.
+void fitness_kernel(const int *x, const int *y, const int *z, int n, int *lin, int *risk);
+
+const char *fitness_kernel_name(void);
+
+#endif
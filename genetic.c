@@ -6,6 +6,10 @@
 #include "genetic.h"
 #include "pool.h"
 #include "config.h"
+#include "fitness_simd.h"
+#include "grid.h"
+#include "genome.h"
+#include "rng.h"
 
 StartMode g_start_mode = START_RANDOM;
 
@@ -21,7 +25,7 @@ int is_valid(Coord c){
 }
 int get_cell(Coord c){
     if(!is_valid(c)) return OBSTACLE;
-    return shared->grid[coord_index(c)];
+    return grid_cell(c.x,c.y,c.z);
 }
 
 static int is_edge_cell(Coord c){
@@ -30,28 +34,28 @@ static int is_edge_cell(Coord c){
             c.z==0 || c.z==config.grid_z-1);
 }
 
-static Coord pick_start_coord(void){
+static Coord pick_start_coord(Rng *rng){
     Coord c;
     if(g_start_mode==START_TOP){
         do{
-            c.x = rand()%config.grid_x;
-            c.y = rand()%config.grid_y;
+            c.x = rng_below(rng,config.grid_x);
+            c.y = rng_below(rng,config.grid_y);
             c.z = config.grid_z-1;
         } while(get_cell(c)==OBSTACLE);
         return c;
     }
     if(g_start_mode==START_EDGES){
         do{
-            c.x = rand()%config.grid_x;
-            c.y = rand()%config.grid_y;
-            c.z = rand()%config.grid_z;
+            c.x = rng_below(rng,config.grid_x);
+            c.y = rng_below(rng,config.grid_y);
+            c.z = rng_below(rng,config.grid_z);
         } while(!is_edge_cell(c) || get_cell(c)==OBSTACLE);
         return c;
     }
     do{
-        c.x = rand()%config.grid_x;
-        c.y = rand()%config.grid_y;
-        c.z = rand()%config.grid_z;
+        c.x = rng_below(rng,config.grid_x);
+        c.y = rng_below(rng,config.grid_y);
+        c.z = rng_below(rng,config.grid_z);
     } while(get_cell(c)==OBSTACLE);
     return c;
 }
@@ -75,225 +79,470 @@ static void parse_priorities_into_shared(void){
     }
 }
 
-void init_grid(void){
-    int grid_size = config.grid_x*config.grid_y*config.grid_z;
-    for(int i=0;i<grid_size;i++) shared->grid[i]=EMPTY;
+// Survivor lookup table for calculate_fitness; the risk term is read
+// straight from the obstacle bitset.
+static void build_fitness_fields(void){
+    grid_index_survivors();
+
+    shared->total_priority=0;
+    for(int s=0;s<config.num_survivors;s++)
+        shared->total_priority += shared->survivor_priority[s];
+}
+
+void init_grid(Rng *rng){
+    grid_clear();
 
     // obstacles
     for(int i=0;i<config.num_obstacles;i++){
         Coord c;
-        int id;
         do{
-            c.x=rand()%config.grid_x;
-            c.y=rand()%config.grid_y;
-            c.z=rand()%config.grid_z;
-            id=coord_index(c);
-        }while(shared->grid[id]!=EMPTY);
+            c.x=rng_below(rng,config.grid_x);
+            c.y=rng_below(rng,config.grid_y);
+            c.z=rng_below(rng,config.grid_z);
+        }while(grid_cell(c.x,c.y,c.z)!=EMPTY);
         shared->obstacles[i]=c;
-        shared->grid[id]=OBSTACLE;
+        grid_set(c,OBSTACLE);
     }
 
     // survivors
     for(int i=0;i<config.num_survivors;i++){
         Coord c;
-        int id;
         do{
-            c.x=rand()%config.grid_x;
-            c.y=rand()%config.grid_y;
-            c.z=rand()%config.grid_z;
-            id=coord_index(c);
-        }while(shared->grid[id]!=EMPTY);
+            c.x=rng_below(rng,config.grid_x);
+            c.y=rng_below(rng,config.grid_y);
+            c.z=rng_below(rng,config.grid_z);
+        }while(grid_cell(c.x,c.y,c.z)!=EMPTY);
         shared->survivors[i]=c;
-        shared->grid[id]=SURVIVOR;
+        grid_set(c,SURVIVOR);
     }
 
     parse_priorities_into_shared();
+    build_fitness_fields();
 }
 
-void generate_random_path(Path *p){
+void generate_random_path(Path *p,Rng *rng){
     int max_len = config.max_path_length;
-    if(max_len>MAX_PATH_LENGTH) max_len=MAX_PATH_LENGTH;
-
-    p->length=0;
-    p->fitness=0;
-    p->survivors_reached=0;
-    p->priority_sum=0;
-    p->coverage=0;
-
-    Coord cur = pick_start_coord();
-    p->genes[p->length++] = cur;
+    if(max_len>p->cap) max_len=p->cap;
 
-    Coord dirs[6]={{1,0,0},{-1,0,0},{0,1,0},{0,-1,0},{0,0,1},{0,0,-1}};
+    Coord cur = pick_start_coord(rng);
+    genome_reset(p, cur);
 
     for(int step=1; step<max_len; step++){
         int attempts=0;
+        int d;
         Coord nxt;
         do{
-            int d=rand()%6;
-            nxt=(Coord){cur.x+dirs[d].x, cur.y+dirs[d].y, cur.z+dirs[d].z};
+            d=rng_below(rng,6);
+            nxt=genome_step(cur,d);
             attempts++;
             if(attempts>20){ return; }
         }while(!is_valid(nxt) || get_cell(nxt)==OBSTACLE);
 
-        p->genes[p->length++] = nxt;
+        genome_push(p,d);
         cur=nxt;
     }
 }
 
-void calculate_fitness(Path *p){
-    int grid_size = config.grid_x*config.grid_y*config.grid_z;
-    unsigned char *visited = (unsigned char*)calloc((size_t)grid_size,1);
-    unsigned char *hit = (unsigned char*)calloc((size_t)config.num_survivors,1);
-    if(!visited || !hit){ fprintf(stderr,"alloc failed\n"); exit(1); }
+void scratch_init(FitnessScratch *s){
+    // at most half full: no path is longer than genome_max_cells
+    s->visit_bits = 1;
+    while((1<<s->visit_bits) < 2*genome_max_cells()) s->visit_bits++;
+    s->visit_cell  = (int*)malloc(sizeof(int)<<s->visit_bits);
+    s->visit_stamp = (unsigned int*)calloc((size_t)1<<s->visit_bits,sizeof(unsigned int));
+    if(!s->visit_cell||!s->visit_stamp){ fprintf(stderr,"alloc failed\n"); exit(1); }
+    s->epoch = 0;
+
+    s->batch_cap = FITNESS_BATCH_GENES;
+    if(s->batch_cap<genome_max_cells()) s->batch_cap=genome_max_cells();
+    size_t n = (size_t)s->batch_cap;
+    s->bx    = (int*)malloc(n*sizeof(int));
+    s->by    = (int*)malloc(n*sizeof(int));
+    s->bz    = (int*)malloc(n*sizeof(int));
+    s->blin  = (int*)malloc(n*sizeof(int));
+    s->brisk = (int*)malloc(n*sizeof(int));
+    s->boff  = (int*)malloc((n+1)*sizeof(int));
+    s->bidx  = (int*)malloc(n*sizeof(int));
+    s->bkey  = (unsigned long long*)malloc(n*sizeof(unsigned long long));
+    if(!s->bx||!s->by||!s->bz||!s->blin||!s->brisk||!s->boff||!s->bidx||!s->bkey){
+        fprintf(stderr,"alloc failed\n"); exit(1);
+    }
 
-    int coverage=0;
-    int risk=0;
-    int survivors_unique=0;
-    int priority_sum=0;
+    cache_init(&s->cache, config.fitness_cache_size);
+    s->evaluated = 0;
+    s->skipped = 0;
+}
 
-    for(int i=0;i<p->length;i++){
-        Coord c=p->genes[i];
-        if(!is_valid(c) || get_cell(c)==OBSTACLE){
-            p->fitness = -1e18;
-            free(visited); free(hit);
-            return;
-        }
+void scratch_free(FitnessScratch *s){
+    free(s->visit_cell);
+    free(s->visit_stamp);
+    free(s->bx); free(s->by); free(s->bz);
+    free(s->blin); free(s->brisk); free(s->boff);
+    free(s->bidx); free(s->bkey);
+    cache_free(&s->cache);
+    s->visit_cell = NULL;
+    s->visit_stamp = NULL;
+}
 
-        int id=coord_index(c);
-        if(!visited[id]){ visited[id]=1; coverage++; }
-
-        for(int s=0;s<config.num_survivors;s++){
-            if(!hit[s] &&
-               c.x==shared->survivors[s].x &&
-               c.y==shared->survivors[s].y &&
-               c.z==shared->survivors[s].z){
-                hit[s]=1;
-                survivors_unique++;
-                priority_sum += shared->survivor_priority[s];
-                break;
-            }
-        }
+static unsigned int scratch_next_epoch(FitnessScratch *s){
+    if(++s->epoch==0){
+        // wrapped: old stamps could alias the new epoch
+        memset(s->visit_stamp,0,sizeof(unsigned int)<<s->visit_bits);
+        s->epoch = 1;
+    }
+    return s->epoch;
+}
 
-        for(int dx=-1;dx<=1;dx++)
-        for(int dy=-1;dy<=1;dy++)
-        for(int dz=-1;dz<=1;dz++){
-            Coord n={c.x+dx,c.y+dy,c.z+dz};
-            if(is_valid(n) && get_cell(n)==OBSTACLE) risk++;
-        }
+// Add a cell to the current epoch's visited set; 1 if it was not in it yet.
+static inline int visit(FitnessScratch *s,int id){
+    unsigned int mask = (1u<<s->visit_bits)-1;
+    unsigned int h = ((unsigned int)id*2654435761u) >> (32-s->visit_bits);
+    while(s->visit_stamp[h]==s->epoch){
+        if(s->visit_cell[h]==id) return 0;
+        h = (h+1) & mask;
     }
+    s->visit_stamp[h] = s->epoch;
+    s->visit_cell[h]  = id;
+    return 1;
+}
+
+void calculate_fitness(Path *p, FitnessScratch *sc){
+    calculate_fitness_from(p, 0, sc);
+}
 
-    free(visited); free(hit);
+void calculate_fitness_from(Path *p, int dirty, FitnessScratch *sc){
+    calculate_fitness_batch(p, &dirty, 1, sc);
+}
+
+// Last checkpoint at or before the first changed gene.
+static int resume_ckpt(const Path *p,int dirty){
+    int k = dirty/FITNESS_CKPT_STRIDE;
+    if(dirty<=0 || p->ckpt_count<=0) return 0;
+    if(k>=p->ckpt_count) k=p->ckpt_count-1;
+    return k;
+}
+
+// Cell k*FITNESS_CKPT_STRIDE, one step on from the checkpoint's last cell;
+// the step is read from the genome, so it may be the first changed gene.
+static Coord resume_cell(const Path *p,int k){
+    if(k<=0) return p->start;
+    return genome_step(p->ckpt[k].last,genome_move(p,k*FITNESS_CKPT_STRIDE-1));
+}
 
-    p->survivors_reached = survivors_unique;
-    p->priority_sum      = priority_sum;
-    p->coverage          = coverage;
+// Cell i, walked from the last valid checkpoint before it rather than the start.
+static Coord path_cell(const Path *p,int i){
+    int k = i/FITNESS_CKPT_STRIDE;
+    if(k>=p->ckpt_count) k=p->ckpt_count-1;
+    if(k<0) k=0;
+    Coord c = resume_cell(p,k);
+    for(int g=k*FITNESS_CKPT_STRIDE;g<i;g++) c = genome_step(c,genome_move(p,g));
+    return c;
+}
 
-    // compute total priority and missing
-    int total_priority = 0;
-    for(int s=0;s<config.num_survivors;s++) total_priority += shared->survivor_priority[s];
+// Stamp cells [0,n) into the visited set. They are known to be in the grid,
+// so the walk steps the linear index a move word at a time, with no Coord
+// decoding or bounds checks.
+static void stamp_prefix(const Path *p,int n,FitnessScratch *sc){
+    if(n<=0) return;
+    int X=config.grid_x, XY=config.grid_x*config.grid_y;
+    const int off[6]={1,-1,X,-X,XY,-XY};
+    int id=coord_index(p->start);
+    visit(sc,id);
+    for(int i=0;i<n-1;){
+        unsigned long long w=p->moves[i/GENOME_MOVES_PER_WORD] >> (3*(i%GENOME_MOVES_PER_WORD));
+        for(int j=i%GENOME_MOVES_PER_WORD;j<GENOME_MOVES_PER_WORD && i<n-1;j++,i++,w>>=3){
+            id+=off[w&7];
+            visit(sc,id);
+        }
+    }
+}
 
-    int missing_priority = total_priority - priority_sum;
+static void finish_fitness(Path *p,const FitnessCkpt *t){
+    p->survivors_reached = t->survivors;
+    p->priority_sum      = t->priority;
+    p->coverage          = t->coverage;
+
+    int missing_priority = shared->total_priority - t->priority;
     if(missing_priority < 0) missing_priority = 0;
 
     double miss_penalty = config.missing_priority_penalty * (double)missing_priority;
     double full_bonus   = (missing_priority == 0) ? config.full_rescue_bonus : 0.0;
 
     p->fitness = full_bonus
-               + config.w1 * (double)priority_sum
-               + config.w2 * (double)coverage
+               + config.w1 * (double)t->priority
+               + config.w2 * (double)t->coverage
                - config.w3 * (double)p->length
-               - config.w4 * (double)risk
+               - config.w4 * (double)t->risk
                - miss_penalty;
 }
 
-static int cmp_desc(const void *a,const void *b){
-    const Path *pa=(const Path*)a, *pb=(const Path*)b;
-    if(pb->fitness>pa->fitness) return 1;
-    if(pb->fitness<pa->fitness) return -1;
-    return 0;
+// Scalar tail of the batch: coverage and survivors depend on the visited
+// set, so they are walked per path over the kernel's index/risk output.
+// bx/by/bz are the path's transposed cells from `start` on.
+static void finish_batch_path(Path *p,int dirty,const int *lin,const int *risk,
+                              const int *bx,const int *by,const int *bz,FitnessScratch *sc){
+    scratch_next_epoch(sc);
+
+    int k = resume_ckpt(p,dirty);
+    int start = k*FITNESS_CKPT_STRIDE;
+    FitnessCkpt t = {0};
+    if(k>0) t = p->ckpt[k];
+    p->ckpt_count = k;
+
+    // the prefix is known valid and already counted; only its cells need stamping
+    stamp_prefix(p,start,sc);
+
+    for(int i=start;i<p->length;i++){
+        if(i%FITNESS_CKPT_STRIDE==0){
+            if(i>start) t.last = (Coord){bx[i-1-start],by[i-1-start],bz[i-1-start]};
+            p->ckpt[i/FITNESS_CKPT_STRIDE]=t;
+            p->ckpt_count=i/FITNESS_CKPT_STRIDE+1;
+        }
+
+        int id=lin[i-start];
+        if(id<0){
+            p->fitness = -1e18;
+            return;
+        }
+
+        if(visit(sc,id)){
+            t.coverage++;
+
+            int s=grid_survivor(id);
+            if(s>=0){
+                t.survivors++;
+                t.priority += shared->survivor_priority[s];
+            }
+        }
+
+        t.risk += risk[i-start];
+    }
+
+    finish_fitness(p,&t);
 }
 
-static int tournament_pick(Path *pop,int N){
-    int best=rand()%N;
+void calculate_fitness_batch(Path *paths, const int *dirty, int n, FitnessScratch *sc){
+    FitnessCache *cache = &sc->cache;
+    int i=0;
+    while(i<n){
+        // transpose as many paths as fit into the SoA buffers
+        int total=0, np=0;
+        while(i<n){
+            Path *p=&paths[i];
+            int k=resume_ckpt(p,dirty[i]);
+
+            // an evaluated path whose genes were not touched keeps its fitness
+            if(dirty[i]>=p->length && p->ckpt_count>0){ sc->skipped++; i++; continue; }
+
+            unsigned long long key=0;
+            if(cache->num_sets>0 && p->length>0){
+                key=genome_hash(p);
+                if(cache_lookup(cache,key,p)){
+                    // checkpoints past the first changed gene are stale
+                    if(p->ckpt_count>k+1) p->ckpt_count=k+1;
+                    i++;
+                    continue;
+                }
+            }
+
+            int start=k*FITNESS_CKPT_STRIDE;
+            int cnt=p->length-start;
+            if(cnt<0) cnt=0;
+            if(np>0 && total+cnt>sc->batch_cap) break;
+
+            sc->bidx[np]=i;
+            sc->bkey[np]=key;
+            sc->boff[np++]=total;
+            Coord c=resume_cell(p,k);
+            for(int g=0;g<cnt;g++){
+                if(g>0) c=genome_step(c,genome_move(p,start+g-1));
+                sc->bx[total+g]=c.x; sc->by[total+g]=c.y; sc->bz[total+g]=c.z;
+            }
+            total+=cnt;
+            i++;
+        }
+        sc->boff[np]=total;
+
+        fitness_kernel(sc->bx,sc->by,sc->bz,total,sc->blin,sc->brisk);
+
+        for(int j=0;j<np;j++){
+            int o=sc->boff[j];
+            Path *p=&paths[sc->bidx[j]];
+            finish_batch_path(p,dirty[sc->bidx[j]],sc->blin+o,sc->brisk+o,sc->bx+o,sc->by+o,sc->bz+o,sc);
+            sc->evaluated++;
+            if(cache->num_sets>0 && p->length>0) cache_insert(cache,sc->bkey[j],p);
+        }
+    }
+}
+
+// Elites are ranked through (fitness, index) pairs so sorting never moves
+// a Path; ties keep the lower index first.
+typedef struct {
+    double fitness;
+    int    idx;
+} FitRank;
+
+static int cmp_rank(const void *a,const void *b){
+    const FitRank *ra=(const FitRank*)a, *rb=(const FitRank*)b;
+    if(rb->fitness>ra->fitness) return 1;
+    if(rb->fitness<ra->fitness) return -1;
+    return ra->idx - rb->idx;
+}
+
+static int tournament_pick(const Path *pop,int N,Rng *rng){
+    int best=rng_below(rng,N);
     for(int i=1;i<config.tournament_size;i++){
-        int c=rand()%N;
+        int c=rng_below(rng,N);
         if(pop[c].fitness>pop[best].fitness) best=c;
     }
     return best;
 }
 
-static void crossover(const Path *p1,const Path *p2,Path *child){
+// The child takes p1's first cp cells, then replays p2's moves from cell
+// cp-1 on until one would leave the grid or hit an obstacle.
+// Returns the index of the first gene not inherited from p1.
+int crossover(const Path *p1,const Path *p2,Path *child,Rng *rng){
     int min_len = (p1->length<p2->length)?p1->length:p2->length;
-    if(min_len<=2){ *child=*p1; return; }
+    if(min_len<=2){ genome_copy(child,p1); return child->length; }
+
+    int cp = 1 + rng_below(rng,min_len-1); // ensure >=1 keeps start
+
+    int nw = (cp-1+GENOME_MOVES_PER_WORD-1)/GENOME_MOVES_PER_WORD;
+    memcpy(child->moves,p1->moves,(size_t)nw*sizeof(unsigned long long));
+    child->start  = p1->start;
+    child->length = cp;
+
+    Coord c = path_cell(p1,cp-1);
+    for(int i=cp-1;i<p2->length-1 && child->length<child->cap;i++){
+        int d = genome_move(p2,i);
+        Coord nc = genome_step(c,d);
+        if(!grid_free(nc)) break;
+        genome_push(child,d);
+        c = nc;
+    }
 
-    int cp = 1 + rand()%(min_len-1); // ensure >=1 keeps start
-    child->length=0;
+    // checkpoints covering only the p1 prefix stay valid for the child
+    int nck = cp/FITNESS_CKPT_STRIDE+1;
+    if(nck>p1->ckpt_count) nck=p1->ckpt_count;
+    memcpy(child->ckpt,p1->ckpt,(size_t)nck*sizeof(FitnessCkpt));
+    child->ckpt_count=nck;
+    // a child cut back to the p1 prefix still differs from p1 in length
+    return (cp<child->length) ? cp : child->length-1;
+}
 
-    child->genes[child->length++] = p1->genes[0]; // force start
+// Moves one cell without breaking the path: an inner cell swaps the moves
+// on either side of it (a corner flip), the last cell gets a new final move.
+// Returns the index of the changed gene, or p->length if none changed;
+// checkpoints past that gene are dropped.
+int mutate(Path *p,Rng *rng){
+    if(rng_unit(rng)>=config.mutation_rate) return p->length;
+    if(p->length<2) return p->length;
 
-    for(int i=1;i<cp && child->length<MAX_PATH_LENGTH;i++)
-        child->genes[child->length++] = p1->genes[i];
+    // IMPORTANT: never mutate gene[0] so start-mode never breaks
+    int mp = 1 + rng_below(rng,p->length-1);
+    Coord prev = path_cell(p,mp-1);
+
+    if(mp==p->length-1){
+        int d=rng_below(rng,6);
+        if(!grid_free(genome_step(prev,d))) return p->length;
+        genome_set_move(p,mp-1,d);
+        if(p->ckpt_count>mp/FITNESS_CKPT_STRIDE+1) p->ckpt_count=mp/FITNESS_CKPT_STRIDE+1;
+        return mp;
+    }
 
-    for(int i=cp;i<p2->length && child->length<MAX_PATH_LENGTH;i++)
-        child->genes[child->length++] = p2->genes[i];
+    int a=genome_move(p,mp-1), b=genome_move(p,mp);
+    if(a==b) return p->length; // straight run, nothing to flip
+    if(!grid_free(genome_step(prev,b))) return p->length;
+    genome_set_move(p,mp-1,b);
+    genome_set_move(p,mp,a);
+    if(p->ckpt_count>mp/FITNESS_CKPT_STRIDE+1) p->ckpt_count=mp/FITNESS_CKPT_STRIDE+1;
+    return mp;
 }
 
-static void mutate(Path *p){
-    double r=(double)rand()/(double)RAND_MAX;
-    if(r>config.mutation_rate) return;
-    if(p->length<2) return;
-
-    // IMPORTANT: never mutate gene[0] so start-mode never breaks
-    int mp = 1 + rand()%(p->length-1);
+int select_elites(const Path *pop,int N,Path *next){
+    int elite=(int)(config.elitism_percent*N);
+    if(elite<1) elite=1;
 
-    Coord dirs[6]={{1,0,0},{-1,0,0},{0,1,0},{0,-1,0},{0,0,1},{0,0,-1}};
-    int d=rand()%6;
+    FitRank rank[N];
+    for(int i=0;i<N;i++){ rank[i].fitness=pop[i].fitness; rank[i].idx=i; }
+    qsort(rank,(size_t)N,sizeof(FitRank),cmp_rank);
 
-    Coord nc={p->genes[mp].x+dirs[d].x, p->genes[mp].y+dirs[d].y, p->genes[mp].z+dirs[d].z};
-    if(is_valid(nc) && get_cell(nc)!=OBSTACLE) p->genes[mp]=nc;
+    for(int i=0;i<elite;i++) genome_copy(&next[i],&pop[rank[i].idx]);
+    return elite;
 }
 
-void evolve_population_local(Path *pop,int N){
-    qsort(pop,(size_t)N,sizeof(Path),cmp_desc);
+void breed_children(const Path *pop,int N,Path *next,int from,int to,FitnessScratch *s,Rng *rng){
+    int dirty[to-from];
 
-    int elite=(int)(config.elitism_percent*N);
-    if(elite<1) elite=1;
+    for(int i=from;i<to;i++){
+        int p1=tournament_pick(pop,N,rng);
+        int p2=tournament_pick(pop,N,rng);
+
+        Path *child=&next[i];
+        int *d=&dirty[i-from];
+        if(rng_unit(rng)<config.crossover_rate) *d=crossover(&pop[p1],&pop[p2],child,rng);
+        else { genome_copy(child,&pop[p1]); *d=child->length; }
 
-    Path *newp=(Path*)malloc((size_t)N*sizeof(Path));
-    if(!newp){ fprintf(stderr,"alloc failed\n"); exit(1); }
+        int md=mutate(child,rng);
+        if(md<*d) *d=md;
+    }
 
-    for(int i=0;i<elite;i++) newp[i]=pop[i];
+    calculate_fitness_batch(next+from,dirty,to-from,s);
+}
 
-    for(int i=elite;i<N;i++){
-        int p1=tournament_pick(pop,N);
-        int p2=tournament_pick(pop,N);
+void evolve_population_local(Path **popp,Path **nextp,int N,FitnessScratch *s,Rng *rng){
+    Path *pop=*popp, *newp=*nextp;
 
-        Path child;
-        double cr=(double)rand()/(double)RAND_MAX;
-        if(cr<=config.crossover_rate) crossover(&pop[p1],&pop[p2],&child);
-        else child=pop[p1];
+    int elite=select_elites(pop,N,newp);
+    breed_children(pop,N,newp,elite,N,s,rng);
 
-        mutate(&child);
-        calculate_fitness(&child);
-        newp[i]=child;
+    *popp=newp;
+    *nextp=pop;
+}
+
+// The member a steady-state child competes with: the worst one, or the
+// loser of a tournament_size draw.
+static int steady_victim(const Path *pop,int N,Rng *rng){
+    if(strcmp(config.steady_replace,"tournament")==0){
+        int worst=rng_below(rng,N);
+        for(int i=1;i<config.tournament_size;i++){
+            int c=rng_below(rng,N);
+            if(pop[c].fitness<pop[worst].fitness) worst=c;
+        }
+        return worst;
     }
+    int worst=N-1;
+    for(int i=N-2;i>=0;i--)
+        if(pop[i].fitness<pop[worst].fitness) worst=i;
+    return worst;
+}
+
+int steady_step(Path *pop,int N,Path *kids,int n,FitnessScratch *s,Rng *rng){
+    breed_children(pop,N,kids,0,n,s,rng);
 
-    memcpy(pop,newp,(size_t)N*sizeof(Path));
-    free(newp);
+    int inserted=0;
+    for(int i=0;i<n;i++){
+        int v=steady_victim(pop,N,rng);
+        if(kids[i].fitness>pop[v].fitness){
+            genome_copy(&pop[v],&kids[i]);
+            inserted++;
+        }
+    }
+    return inserted;
 }
 
-void init_population(Path *population){
+void init_population(Path *population,FitnessScratch *s,Rng *rng){
     for(int i=0;i<config.population_size;i++){
-        generate_random_path(&population[i]);
-        calculate_fitness(&population[i]);
+        generate_random_path(&population[i],rng);
+        calculate_fitness(&population[i],s);
     }
     shared->best_fitness = -1e18;
-    shared->best_path = population[0];
+    shared->best_worker = -1;
+    genome_copy(&shared->best_path,&population[0]);
 
     for(int i=0;i<config.population_size;i++){
         if(population[i].fitness>shared->best_fitness){
             shared->best_fitness=population[i].fitness;
-            shared->best_path=population[i];
+            genome_copy(&shared->best_path,&population[i]);
         }
     }
 }
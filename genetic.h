@@ -2,6 +2,8 @@
 #define GENETIC_H
 
 #include "types.h"
+#include "fitness_cache.h"
+#include "rng.h"
 
 typedef enum {
     START_TOP = 1,
@@ -11,13 +13,66 @@ typedef enum {
 
 extern StartMode g_start_mode;
 
-void init_grid(void);
-void init_population(Path *population);
+// Genes transposed per fitness_kernel call; scratch_init raises it to the
+// longest path if needed.
+#define FITNESS_BATCH_GENES 4096
 
-void generate_random_path(Path *path);
-void calculate_fitness(Path *path);
+// Per-worker evaluation scratch. The cells a path visits go into a small
+// open-addressing set sized by the path length, not the grid; slots are
+// stamped with the current epoch, so it is never cleared between evaluations.
+// bx/by/bz hold a batch of genes in SoA layout for fitness_kernel.
+typedef struct {
+    int          *visit_cell;
+    unsigned int *visit_stamp;
+    int           visit_bits;   // log2 of the slot count
+    unsigned int  epoch;
 
-void evolve_population_local(Path *population, int N);
+    int  batch_cap;
+    int *bx, *by, *bz;
+    int *blin, *brisk;
+    int *boff, *bidx;
+    unsigned long long *bkey;
+
+    FitnessCache cache;
+    long evaluated;  // paths run through the kernel
+    long skipped;    // untouched copies that kept their fitness
+} FitnessScratch;
+
+void scratch_init(FitnessScratch *s);
+void scratch_free(FitnessScratch *s);
+
+void init_grid(Rng *rng);
+void init_population(Path *population, FitnessScratch *s, Rng *rng);
+
+void generate_random_path(Path *path, Rng *rng);
+void calculate_fitness(Path *path, FitnessScratch *s);
+// Re-evaluate a path whose genes before `dirty` match the ones its
+// checkpoints were recorded over (e.g. a crossover or mutation child).
+void calculate_fitness_from(Path *path, int dirty, FitnessScratch *s);
+// Evaluate n paths at once through the vectorised kernel; bit-identical
+// to calling calculate_fitness_from on each.
+void calculate_fitness_batch(Path *paths, const int *dirty, int n, FitnessScratch *s);
+
+// The operators breed_children applies, exported for the microbenchmarks.
+// Both return the first changed gene (p->length / child->length if none).
+int  crossover(const Path *p1, const Path *p2, Path *child, Rng *rng);
+int  mutate(Path *p, Rng *rng);
+
+// The two halves of a generation, for callers that split the children:
+// select_elites copies the best into next[0..elite) and returns elite;
+// breed_children fills and evaluates next[from..to) from pop.
+int  select_elites(const Path *pop, int N, Path *next);
+void breed_children(const Path *pop, int N, Path *next, int from, int to, FitnessScratch *s, Rng *rng);
+
+// One generation from *pop into *next (both N paths from genome_alloc, same
+// cap); children are built in place and the two pointers are swapped.
+void evolve_population_local(Path **pop, Path **next, int N, FitnessScratch *s, Rng *rng);
+
+// ga_mode=steady: breed n children from pop into kids (n paths, same cap)
+// and copy each over its victim (config.steady_replace) if it is fitter.
+// Returns the number inserted. Parents are drawn before any insertion.
+#define STEADY_BATCH 8
+int  steady_step(Path *pop, int N, Path *kids, int n, FitnessScratch *s, Rng *rng);
 
 int  is_valid(Coord c);
 int  get_cell(Coord c);
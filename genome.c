@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "genome.h"
+
+const Coord genome_dirs[6]={{1,0,0},{-1,0,0},{0,1,0},{0,-1,0},{0,0,1},{0,0,-1}};
+
+char *genome_bind(Path *paths, int n, int cap, char *mem){
+    for(int i=0;i<n;i++){
+        Path *p = &paths[i];
+        p->cap   = cap;
+        p->moves = (unsigned long long *)mem;
+        p->ckpt  = (FitnessCkpt *)(mem + (size_t)genome_words(cap)*sizeof(unsigned long long));
+        mem += genome_bytes(cap);
+        genome_reset(p, (Coord){0,0,0});
+    }
+    return mem;
+}
+
+Path *genome_alloc(int n, int cap){
+    Path *paths = (Path *)malloc((size_t)n*(sizeof(Path) + genome_bytes(cap)));
+    if(!paths){ fprintf(stderr,"alloc failed\n"); exit(1); }
+    genome_bind(paths, n, cap, (char *)(paths + n));
+    return paths;
+}
+
+void genome_reset(Path *p, Coord start){
+    p->start  = start;
+    p->length = 1;
+    p->fitness = 0;
+    p->survivors_reached = 0;
+    p->priority_sum = 0;
+    p->coverage = 0;
+    p->ckpt_count = 0;
+}
+
+int genome_push(Path *p, int d){
+    if(p->length>=p->cap) return 0;
+    genome_set_move(p, p->length-1, d);
+    p->length++;
+    return 1;
+}
+
+int genome_append(Path *p, Coord from, Coord to){
+    for(int d=0;d<6;d++){
+        Coord c = genome_step(from, d);
+        if(c.x==to.x && c.y==to.y && c.z==to.z) return genome_push(p, d);
+    }
+    return 0;
+}
+
+Coord genome_cell(const Path *p, int i){
+    Coord c = p->start;
+    for(int k=0;k<i;k++) c = genome_step(c, genome_move(p,k));
+    return c;
+}
+
+void genome_copy(Path *dst, const Path *src){
+    int len = (src->length<dst->cap) ? src->length : dst->cap;
+    int nw  = (len-1+GENOME_MOVES_PER_WORD-1)/GENOME_MOVES_PER_WORD;
+    int nck = (src->ckpt_count<genome_ckpts(dst->cap)) ? src->ckpt_count : genome_ckpts(dst->cap);
+
+    memcpy(dst->moves, src->moves, (size_t)nw*sizeof(unsigned long long));
+    memcpy(dst->ckpt, src->ckpt, (size_t)nck*sizeof(FitnessCkpt));
+    dst->start   = src->start;
+    dst->length  = len;
+    dst->fitness = src->fitness;
+    dst->survivors_reached = src->survivors_reached;
+    dst->priority_sum = src->priority_sum;
+    dst->coverage = src->coverage;
+    dst->ckpt_count = nck;
+}
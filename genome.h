@@ -0,0 +1,79 @@
+#ifndef GENOME_H
+#define GENOME_H
+
+#include <stddef.h>
+
+#include "types.h"
+#include "config.h"
+
+// Path genome: the start cell plus one 3-bit move code per step, 21 codes
+// to a 64-bit word. Move i leads from cell i to cell i+1; codes index
+// genome_dirs, and d^1 is the opposite direction of d. The move words and
+// checkpoints of a Path live in storage carved out by genome_bind, sized for
+// `cap` cells, so a path is contiguous by construction and its size follows
+// config.max_path_length instead of a compile-time limit.
+
+#define GENOME_MOVES_PER_WORD 21
+
+extern const Coord genome_dirs[6];
+
+static inline int genome_words(int cap){
+    int w = (cap-1+GENOME_MOVES_PER_WORD-1)/GENOME_MOVES_PER_WORD;
+    return (w>0) ? w : 1;
+}
+
+// checkpoint k is taken at cell k*FITNESS_CKPT_STRIDE
+static inline int genome_ckpts(int cap){
+    return (cap-1)/FITNESS_CKPT_STRIDE + 1;
+}
+
+// Storage behind one path, rounded to a multiple of 8 so slots stay aligned.
+static inline size_t genome_bytes(int cap){
+    size_t n = (size_t)genome_words(cap)*sizeof(unsigned long long) +
+               (size_t)genome_ckpts(cap)*sizeof(FitnessCkpt);
+    return (n+7) & ~(size_t)7;
+}
+
+// Longest path any caller needs: the GA limit, or the baseline's.
+static inline int genome_max_cells(void){
+    return (config.max_path_length>BASELINE_PATH_LENGTH) ? config.max_path_length : BASELINE_PATH_LENGTH;
+}
+
+static inline int genome_move(const Path *p,int i){
+    return (int)(p->moves[i/GENOME_MOVES_PER_WORD] >> (3*(i%GENOME_MOVES_PER_WORD))) & 7;
+}
+
+static inline void genome_set_move(Path *p,int i,int d){
+    unsigned long long *w = &p->moves[i/GENOME_MOVES_PER_WORD];
+    int sh = 3*(i%GENOME_MOVES_PER_WORD);
+    *w = (*w & ~(7ULL<<sh)) | ((unsigned long long)d<<sh);
+}
+
+static inline Coord genome_step(Coord c,int d){
+    return (Coord){c.x+genome_dirs[d].x, c.y+genome_dirs[d].y, c.z+genome_dirs[d].z};
+}
+
+// Point n paths at consecutive storage slots starting at mem; returns the
+// first byte after them.
+char *genome_bind(Path *paths, int n, int cap, char *mem);
+
+// Per-worker arena: n path headers and their storage in one block, released
+// with free().
+Path *genome_alloc(int n, int cap);
+
+// Empty the path down to its start cell.
+void genome_reset(Path *p, Coord start);
+
+// Append the step `from` -> `to`; 0 if the path is full or the cells are
+// not neighbours.
+int  genome_append(Path *p, Coord from, Coord to);
+int  genome_push(Path *p, int d);
+
+// Cell i, walking the moves from the start.
+Coord genome_cell(const Path *p, int i);
+
+// Copies genome, stats and checkpoints; dst keeps its own storage and the
+// copy is cut to dst->cap cells.
+void genome_copy(Path *dst, const Path *src);
+
+#endif
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "grid.h"
+
+static size_t dense_bytes(void){
+    return grid_cell_bytes() + grid_obstacle_bytes();
+}
+
+static size_t chunked_bytes(void){
+    return (size_t)grid_num_chunks()*sizeof(int) + (size_t)grid_brick_cap()*BRICK_BYTES;
+}
+
+size_t grid_shared_bytes(void){
+    size_t b = (strcmp(config.grid_storage,"chunked")==0) ? chunked_bytes() : dense_bytes();
+    return b + (size_t)2*grid_survivor_slots()*sizeof(int);
+}
+
+char *grid_attach(char *ptr){
+    shared->chunked = (strcmp(config.grid_storage,"chunked")==0);
+
+    // int arrays first so they stay aligned
+    shared->survivor_table = (int *)ptr;
+    ptr += (size_t)2*grid_survivor_slots()*sizeof(int);
+
+    if(shared->chunked){
+        shared->chunk_dir = (int *)ptr;
+        ptr += (size_t)grid_num_chunks()*sizeof(int);
+        shared->bricks = (unsigned char *)ptr;
+        ptr += (size_t)grid_brick_cap()*BRICK_BYTES;
+        shared->cells = NULL;
+        shared->obstacle_bits = NULL;
+    } else {
+        shared->cells = (unsigned char *)ptr;
+        ptr += grid_cell_bytes();
+        shared->obstacle_bits = (unsigned char *)ptr;
+        ptr += grid_obstacle_bytes();
+        shared->chunk_dir = NULL;
+        shared->bricks = NULL;
+    }
+    return ptr;
+}
+
+void grid_clear(void){
+    if(shared->chunked){
+        for(int i=0;i<grid_num_chunks();i++) shared->chunk_dir[i]=-1;
+        shared->bricks_used = 0;
+    } else {
+        memset(shared->cells, 0, grid_cell_bytes());  // EMPTY == 0
+        memset(shared->obstacle_bits, 0, grid_obstacle_bytes());
+    }
+    for(int i=0;i<2*grid_survivor_slots();i++) shared->survivor_table[i]=-1;
+}
+
+static void set_bits(unsigned char *cells, int l, int state,
+                     unsigned char *obst_byte, unsigned char bit){
+    unsigned char *b = &cells[l>>2];
+    int sh = (l&3)*2;
+    *b = (unsigned char)((*b & ~(3<<sh)) | (state<<sh));
+    if(state==OBSTACLE) *obst_byte |= bit;
+    else                *obst_byte &= (unsigned char)~bit;
+}
+
+void grid_set(Coord c, int state){
+    if(!shared->chunked){
+        unsigned char *row = shared->obstacle_bits + grid_row_offset(c.y,c.z);
+        set_bits(shared->cells, grid_idx3(c.x,c.y,c.z), state,
+                 &row[(c.x+1)>>3], (unsigned char)(1u << ((c.x+1)&7)));
+        return;
+    }
+
+    int *slot = &shared->chunk_dir[grid_chunk_of(c.x,c.y,c.z)];
+    if(*slot<0){
+        if(state==EMPTY) return;
+        if(shared->bricks_used>=grid_brick_cap()){
+            fprintf(stderr,"chunk pool exhausted\n");
+            exit(1);
+        }
+        *slot = shared->bricks_used++;
+        memset(shared->bricks + (size_t)*slot*BRICK_BYTES, 0, BRICK_BYTES);
+    }
+
+    unsigned char *brick = shared->bricks + (size_t)*slot*BRICK_BYTES;
+    int lx = c.x&(CHUNK-1), ly = c.y&(CHUNK-1), lz = c.z&(CHUNK-1);
+    unsigned char *row = brick + BRICK_CELL_BYTES + 2*(ly | lz<<CHUNK_SHIFT);
+    set_bits(brick, lx | ly<<CHUNK_SHIFT | lz<<(2*CHUNK_SHIFT), state,
+             &row[lx>>3], (unsigned char)(1u << (lx&7)));
+}
+
+void grid_index_survivors(void){
+    unsigned mask = (unsigned)grid_survivor_slots()-1;
+    for(int i=0;i<2*grid_survivor_slots();i++) shared->survivor_table[i]=-1;
+    for(int s=0;s<config.num_survivors;s++){
+        Coord c = shared->survivors[s];
+        int lin = grid_idx3(c.x,c.y,c.z);
+        unsigned h = grid_survivor_hash(lin) & mask;
+        while(shared->survivor_table[2*h]>=0) h = (h+1) & mask;
+        shared->survivor_table[2*h]   = lin;
+        shared->survivor_table[2*h+1] = s;
+    }
+}
+
+void grid_get_stats(GridStats *out){
+    memset(out,0,sizeof(*out));
+    out->chunked     = shared->chunked;
+    out->chunks      = grid_num_chunks();
+    out->bytes       = grid_shared_bytes();
+    out->dense_bytes = dense_bytes() + (size_t)2*grid_survivor_slots()*sizeof(int);
+    if(!shared->chunked) return;
+
+    out->bricks  = shared->bricks_used;
+    out->uniform = out->chunks - out->bricks;
+    long total = 0;
+    for(int b=0;b<shared->bricks_used;b++){
+        const unsigned char *rows = grid_brick(b) + BRICK_CELL_BYTES;
+        int n = 0;
+        for(int r=0;r<CHUNK*CHUNK*2;r++) n += __builtin_popcount(rows[r]);
+        if(n>out->max_obstacles) out->max_obstacles = n;
+        total += n;
+    }
+    if(out->bricks>0) out->mean_obstacles = (double)total/(double)out->bricks;
+}
@@ -0,0 +1,194 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <stddef.h>
+
+#include "types.h"
+#include "pool.h"
+#include "config.h"
+
+// Occupancy grid in shared memory, laid out by grid_attach. Two storages,
+// picked by config.grid_storage:
+//
+// dense:
+//  - cells: 2 bits per cell (EMPTY / OBSTACLE / SURVIVOR), linear index order.
+//  - obstacle bits: 1 bit per cell in rows along x. Column x is bit x+1 and
+//    there is a zero guard row on every side in y and z, so the 3x3x3 risk
+//    window never needs a bounds check.
+//
+// chunked: the grid is cut into 16^3 chunks. chunk_dir holds a brick index
+// per chunk, or -1 for a chunk that is uniformly EMPTY and has no brick.
+// A brick is the chunk's 2-bit cells followed by 256 rows of 16 obstacle
+// bits; bricks are taken from a pool sized for one per obstacle/survivor.
+//
+// Both share the survivor table: open addressing, linear cell index ->
+// survivor index.
+
+#define CHUNK_SHIFT       4
+#define CHUNK             (1<<CHUNK_SHIFT)
+#define BRICK_CELL_BYTES  (CHUNK*CHUNK*CHUNK/4)
+#define BRICK_BYTES       (BRICK_CELL_BYTES + CHUNK*CHUNK*2)
+
+static inline int grid_idx3(int x,int y,int z){
+    return z*config.grid_x*config.grid_y + y*config.grid_x + x;
+}
+
+static inline int grid_row_bytes(void){
+    return (config.grid_x+2+7)/8;
+}
+
+static inline size_t grid_cell_bytes(void){
+    return ((size_t)config.grid_x*config.grid_y*config.grid_z+3)/4;
+}
+
+// +3: fitness_kernel reads rows with 4-byte gathers
+static inline size_t grid_obstacle_bytes(void){
+    return (size_t)grid_row_bytes()*(size_t)(config.grid_y+2)*(size_t)(config.grid_z+2) + 3;
+}
+
+static inline int grid_chunks_x(void){ return (config.grid_x+CHUNK-1)>>CHUNK_SHIFT; }
+static inline int grid_chunks_y(void){ return (config.grid_y+CHUNK-1)>>CHUNK_SHIFT; }
+static inline int grid_chunks_z(void){ return (config.grid_z+CHUNK-1)>>CHUNK_SHIFT; }
+static inline int grid_num_chunks(void){ return grid_chunks_x()*grid_chunks_y()*grid_chunks_z(); }
+
+// Every obstacle or survivor dirties at most one chunk.
+static inline int grid_brick_cap(void){
+    long n = (long)config.num_obstacles + config.num_survivors;
+    return (n < grid_num_chunks()) ? (int)n : grid_num_chunks();
+}
+
+static inline int grid_survivor_slots(void){
+    int n=2;
+    while(n<2*config.num_survivors) n*=2;
+    return n;
+}
+
+static inline size_t grid_row_offset(int y,int z){
+    return ((size_t)(z+1)*(size_t)(config.grid_y+2)+(size_t)(y+1))*(size_t)grid_row_bytes();
+}
+
+static inline int grid_chunk_of(int x,int y,int z){
+    return (x>>CHUNK_SHIFT) + ((y>>CHUNK_SHIFT) + (z>>CHUNK_SHIFT)*grid_chunks_y())*grid_chunks_x();
+}
+
+static inline const unsigned char *grid_brick(int b){
+    return shared->bricks + (size_t)b*BRICK_BYTES;
+}
+
+// Obstacle bits of a brick row (local y, z), bit = local x.
+static inline unsigned grid_brick_row(const unsigned char *brick,int y,int z){
+    const unsigned char *r = brick + BRICK_CELL_BYTES + 2*((y&(CHUNK-1)) | (z&(CHUNK-1))<<CHUNK_SHIFT);
+    return r[0] | (unsigned)r[1]<<8;
+}
+
+// Cell state; coordinates must be in range.
+static inline int grid_cell(int x,int y,int z){
+    if(!shared->chunked){
+        int lin = grid_idx3(x,y,z);
+        return (shared->cells[lin>>2] >> ((lin&3)*2)) & 3;
+    }
+    int b = shared->chunk_dir[grid_chunk_of(x,y,z)];
+    if(b<0) return EMPTY;
+    int l = (x&(CHUNK-1)) | (y&(CHUNK-1))<<CHUNK_SHIFT | (z&(CHUNK-1))<<(2*CHUNK_SHIFT);
+    return (grid_brick(b)[l>>2] >> ((l&3)*2)) & 3;
+}
+
+// Coordinates must be in range.
+static inline int grid_obstacle(int x,int y,int z){
+    if(!shared->chunked){
+        const unsigned char *row = shared->obstacle_bits + grid_row_offset(y,z);
+        return (row[(x+1)>>3] >> ((x+1)&7)) & 1;
+    }
+    int b = shared->chunk_dir[grid_chunk_of(x,y,z)];
+    if(b<0) return 0;
+    return (grid_brick_row(grid_brick(b),y,z) >> (x&(CHUNK-1))) & 1;
+}
+
+// Bounds check plus obstacle bit: the test every search does per neighbour.
+static inline int grid_free(Coord c){
+    return (unsigned)c.x<(unsigned)config.grid_x && (unsigned)c.y<(unsigned)config.grid_y &&
+           (unsigned)c.z<(unsigned)config.grid_z && !grid_obstacle(c.x,c.y,c.z);
+}
+
+// Dense: obstacle bits of columns x-1..x+1.
+static inline unsigned grid_window3(const unsigned char *row,int x){
+    unsigned v = row[x>>3] | (unsigned)row[(x>>3)+1]<<8;
+    return (v >> (x&7)) & 7;
+}
+
+// Chunked: the same window for an in-range row; a window that crosses a
+// chunk edge falls back to probing the three columns.
+static inline unsigned grid_chunk_window3(int x,int y,int z){
+    int lx = x&(CHUNK-1);
+    if(lx>=1 && lx<=CHUNK-2){
+        int b = shared->chunk_dir[grid_chunk_of(x,y,z)];
+        if(b<0) return 0;
+        return (grid_brick_row(grid_brick(b),y,z) >> (lx-1)) & 7;
+    }
+    unsigned v = 0;
+    for(int dx=-1;dx<=1;dx++){
+        int xx = x+dx;
+        v = (v<<1) | ((unsigned)xx<(unsigned)config.grid_x && grid_obstacle(xx,y,z));
+    }
+    return v;
+}
+
+// Obstacles in the 3x3x3 block around an in-range cell: the nine row
+// windows are packed into one word and counted with a single popcount.
+static inline int grid_risk(int x,int y,int z){
+    unsigned v = 0;
+    if(!shared->chunked){
+        const unsigned char *base = shared->obstacle_bits;
+        for(int dz=-1;dz<=1;dz++)
+            for(int dy=-1;dy<=1;dy++)
+                v = (v<<3) | grid_window3(base + grid_row_offset(y+dy,z+dz), x);
+        return __builtin_popcount(v);
+    }
+    for(int dz=-1;dz<=1;dz++){
+        if((unsigned)(z+dz)>=(unsigned)config.grid_z) continue;
+        for(int dy=-1;dy<=1;dy++){
+            if((unsigned)(y+dy)>=(unsigned)config.grid_y) continue;
+            v = (v<<3) | grid_chunk_window3(x,y+dy,z+dz);
+        }
+    }
+    return __builtin_popcount(v);
+}
+
+static inline unsigned grid_survivor_hash(int lin){
+    return (unsigned)lin * 2654435761u;
+}
+
+// Survivor index at a linear cell index, -1 if none.
+static inline int grid_survivor(int lin){
+    unsigned mask = (unsigned)grid_survivor_slots()-1;
+    unsigned h = grid_survivor_hash(lin) & mask;
+    while(shared->survivor_table[2*h]>=0){
+        if(shared->survivor_table[2*h]==lin) return shared->survivor_table[2*h+1];
+        h = (h+1) & mask;
+    }
+    return -1;
+}
+
+// Bytes the grid takes in shared memory, and carving them out at ptr
+// (returns the first byte after them).
+size_t grid_shared_bytes(void);
+char  *grid_attach(char *ptr);
+
+void grid_clear(void);
+void grid_set(Coord c, int state);
+void grid_index_survivors(void);
+
+typedef struct {
+    int    chunked;
+    int    chunks;          // 16^3 chunks covering the grid
+    int    uniform;         // chunks without a brick (all EMPTY)
+    int    bricks;
+    int    max_obstacles;   // most obstacles in one brick
+    double mean_obstacles;  // per brick
+    size_t bytes;           // shared memory used by the grid
+    size_t dense_bytes;     // what the dense storage would use
+} GridStats;
+
+void grid_get_stats(GridStats *out);
+
+#endif
@@ -0,0 +1,556 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+
+#include "hpa.h"
+#include "pool.h"
+#include "genetic.h"
+#include "config.h"
+#include "grid.h"
+
+#define UNREACHED (INT_MAX/4)
+
+static const Coord dirs[6]={{1,0,0},{-1,0,0},{0,1,0},{0,-1,0},{0,0,1},{0,0,-1}};
+
+static inline int idx3(int x,int y,int z){
+    return z*config.grid_x*config.grid_y + y*config.grid_x + x;
+}
+static inline int manhattan(Coord a, Coord b){
+    return abs(a.x-b.x)+abs(a.y-b.y)+abs(a.z-b.z);
+}
+static inline Coord cell_coord(int c){
+    int z = c/(config.grid_x*config.grid_y);
+    int rem = c%(config.grid_x*config.grid_y);
+    return (Coord){rem%config.grid_x, rem/config.grid_x, z};
+}
+
+static double now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e3 + (double)ts.tv_nsec/1e6;
+}
+
+static void *xrealloc(void *p, size_t n){
+    p = realloc(p, n);
+    if(!p){ fprintf(stderr,"alloc failed\n"); exit(1); }
+    return p;
+}
+
+static HPAStats stats;
+
+static int C, ncx, ncy, ncz, ncl;
+
+// Entrance graph. Nodes are grid cells; cl_nodes[cl_first[c]..cl_first[c+1])
+// lists the nodes of cluster c, edges are CSR by source node.
+static int  num_nodes, nodes_cap;
+static int *node_cell;
+static int *cl_first, *cl_nodes;
+static int *edge_first, *edge_to, *edge_cost;
+static long num_edges, edges_cap;
+static int *e_from;             // build only
+
+// cell -> node, open addressing
+static int *map_cell, *map_node;
+static int  map_cap;
+
+// BFS inside one cluster box. The box is copied into an open/blocked map
+// with a one-cell blocked border (stride P = C+2), so neighbours are plain
+// index offsets and never leave the box.
+static int bx0, by0, bz0, bw, bh, bd, P;
+static int           box_cl = -1;
+static unsigned char *l_open;
+static int          *l_dist, *l_queue;
+static signed char  *l_dir;
+static unsigned int *l_stamp, l_cur;
+static int           l_off[6];
+
+// Abstract search over num_nodes + 2 slots (start and goal are temporary).
+typedef struct { int f, g, n; } HeapItem;
+static int          *a_g, *a_came, *a_gdist;
+static unsigned char *a_closed;
+static unsigned int *a_stamp, a_cur;
+static HeapItem     *a_heap;
+static int           a_heap_len, a_heap_cap;
+
+// Refined path, grown as legs are appended.
+static Coord *pbuf;
+static int    plen, pcap;
+
+static inline int cluster_of(Coord c){
+    return c.x/C + (c.y/C)*ncx + (c.z/C)*ncx*ncy;
+}
+
+static inline int local_index(Coord c){
+    return (c.x-bx0+1) + (c.y-by0+1)*P + (c.z-bz0+1)*P*P;
+}
+
+static void load_box(int cl){
+    if(cl==box_cl) return;
+    box_cl = cl;
+    bx0 = (cl%ncx)*C;
+    by0 = ((cl/ncx)%ncy)*C;
+    bz0 = (cl/(ncx*ncy))*C;
+    bw = (config.grid_x-bx0 < C) ? config.grid_x-bx0 : C;
+    bh = (config.grid_y-by0 < C) ? config.grid_y-by0 : C;
+    bd = (config.grid_z-bz0 < C) ? config.grid_z-bz0 : C;
+
+    memset(l_open,0,(size_t)P*P*P);
+    for(int z=0;z<bd;z++)
+        for(int y=0;y<bh;y++){
+            unsigned char *o = &l_open[(y+1)*P + (z+1)*P*P + 1];
+            for(int x=0;x<bw;x++) o[x] = !grid_obstacle(bx0+x,by0+y,bz0+z);
+        }
+}
+
+// BFS from src inside the loaded box; stops once `stop` is reached.
+static int local_bfs(Coord src, int stop, long *expanded){
+    if(++l_cur==0){
+        memset(l_stamp,0,(size_t)P*P*P*sizeof(unsigned int));
+        l_cur = 1;
+    }
+    int head=0, tail=0;
+    int s = local_index(src);
+    l_stamp[s]=l_cur; l_dist[s]=0; l_dir[s]=-1;
+    l_queue[tail++]=s;
+
+    while(head<tail){
+        int cur = l_queue[head++];
+        if(expanded) (*expanded)++;
+        if(cur==stop) return 1;
+        for(int k=0;k<6;k++){
+            int ni = cur+l_off[k];
+            if(!l_open[ni] || l_stamp[ni]==l_cur) continue;
+            l_stamp[ni]=l_cur;
+            l_dist[ni]=l_dist[cur]+1;
+            l_dir[ni]=(signed char)k;
+            l_queue[tail++]=ni;
+        }
+    }
+    return 0;
+}
+
+static inline int local_dist(Coord c){
+    int li = local_index(c);
+    return (l_stamp[li]==l_cur) ? l_dist[li] : UNREACHED;
+}
+
+static void path_reserve(int n){
+    if(plen+n<=pcap) return;
+    while(plen+n>pcap) pcap = pcap ? pcap*2 : 1024;
+    pbuf = (Coord*)xrealloc(pbuf,(size_t)pcap*sizeof(Coord));
+}
+
+// Append the BFS path to dst (the BFS source is already the last cell).
+static void append_local(Coord dst){
+    int n = l_dist[local_index(dst)];
+    path_reserve(n);
+    Coord c = dst;
+    for(int i=n-1;i>=0;i--){
+        pbuf[plen+i] = c;
+        int k = l_dir[local_index(c)];
+        c = (Coord){c.x-dirs[k].x, c.y-dirs[k].y, c.z-dirs[k].z};
+    }
+    plen += n;
+}
+
+static inline unsigned int map_hash(int cell){
+    return (unsigned int)cell * 2654435761u;
+}
+
+static int map_find(int cell){
+    unsigned int mask = (unsigned int)(map_cap-1);
+    unsigned int h = map_hash(cell) & mask;
+    while(map_cell[h]>=0){
+        if(map_cell[h]==cell) return map_node[h];
+        h = (h+1) & mask;
+    }
+    return -1;
+}
+
+static void map_put(int cell, int node){
+    unsigned int mask = (unsigned int)(map_cap-1);
+    unsigned int h = map_hash(cell) & mask;
+    while(map_cell[h]>=0) h = (h+1) & mask;
+    map_cell[h] = cell;
+    map_node[h] = node;
+}
+
+static void map_alloc(int cap){
+    map_cap  = cap;
+    map_cell = (int*)xrealloc(NULL,(size_t)cap*sizeof(int));
+    map_node = (int*)xrealloc(NULL,(size_t)cap*sizeof(int));
+    for(int i=0;i<cap;i++) map_cell[i] = -1;
+}
+
+static int node_for_cell(int cell){
+    int n = map_find(cell);
+    if(n>=0) return n;
+
+    if(2*(num_nodes+1) > map_cap){
+        free(map_cell); free(map_node);
+        map_alloc(map_cap*2);
+        for(int i=0;i<num_nodes;i++) map_put(node_cell[i], i);
+    }
+    if(num_nodes==nodes_cap){
+        nodes_cap = nodes_cap ? nodes_cap*2 : 1024;
+        node_cell = (int*)xrealloc(node_cell,(size_t)nodes_cap*sizeof(int));
+    }
+    n = num_nodes++;
+    node_cell[n] = cell;
+    map_put(cell, n);
+    return n;
+}
+
+static void add_edge(int u, int v, int w){
+    if(num_edges==edges_cap){
+        edges_cap = edges_cap ? edges_cap*2 : 4096;
+        e_from    = (int*)xrealloc(e_from,(size_t)edges_cap*sizeof(int));
+        edge_to   = (int*)xrealloc(edge_to,(size_t)edges_cap*sizeof(int));
+        edge_cost = (int*)xrealloc(edge_cost,(size_t)edges_cap*sizeof(int));
+    }
+    e_from[num_edges]    = u;
+    edge_to[num_edges]   = v;
+    edge_cost[num_edges] = w;
+    num_edges++;
+}
+
+// Cell on the face plane `along` of axis a, at face coordinates (u,v).
+static inline Coord face_cell(int a, int along, int u, int v){
+    if(a==0) return (Coord){along,u,v};
+    if(a==1) return (Coord){u,along,v};
+    return (Coord){u,v,along};
+}
+
+// One entrance per connected run of open cell pairs across each face
+// between neighbouring clusters, placed at the cell nearest the run's centre.
+static void build_entrances(void){
+    int *mark  = (int*)xrealloc(NULL,(size_t)C*C*sizeof(int));
+    int *stack = (int*)xrealloc(NULL,(size_t)C*C*sizeof(int));
+    int *comp  = (int*)xrealloc(NULL,(size_t)C*C*sizeof(int));
+    int n_axis[3] = {ncx, ncy, ncz};
+
+    for(int cl=0;cl<ncl;cl++){
+        int cc[3] = {cl%ncx, (cl/ncx)%ncy, cl/(ncx*ncy)};
+        load_box(cl);
+        int lo[3] = {bx0, by0, bz0}, ext[3] = {bw, bh, bd};
+
+        for(int a=0;a<3;a++){
+            if(cc[a]==n_axis[a]-1) continue;
+            int ua = (a==0) ? 1 : 0, va = (a==2) ? 1 : 2;
+            int along = lo[a]+ext[a]-1;   // last layer of this cluster
+
+            for(int v=0;v<ext[va];v++)
+                for(int u=0;u<ext[ua];u++){
+                    Coord p = face_cell(a, along,   lo[ua]+u, lo[va]+v);
+                    Coord q = face_cell(a, along+1, lo[ua]+u, lo[va]+v);
+                    mark[v*C+u] = grid_free(p) && grid_free(q);
+                }
+
+            for(int v=0;v<ext[va];v++)
+                for(int u=0;u<ext[ua];u++){
+                    if(!mark[v*C+u]) continue;
+
+                    int top=0, len=0;
+                    long su=0, sv=0;
+                    mark[v*C+u] = 0;
+                    stack[top++] = v*C+u;
+                    while(top>0){
+                        int f = stack[--top];
+                        comp[len++] = f;
+                        int fu = f%C, fv = f/C;
+                        su += fu; sv += fv;
+                        if(fu>0          && mark[f-1]){ mark[f-1]=0; stack[top++]=f-1; }
+                        if(fu<ext[ua]-1  && mark[f+1]){ mark[f+1]=0; stack[top++]=f+1; }
+                        if(fv>0          && mark[f-C]){ mark[f-C]=0; stack[top++]=f-C; }
+                        if(fv<ext[va]-1  && mark[f+C]){ mark[f+C]=0; stack[top++]=f+C; }
+                    }
+
+                    int best = comp[0];
+                    long bestd = LONG_MAX;
+                    for(int i=0;i<len;i++){
+                        long du = (long)(comp[i]%C)*len - su, dv = (long)(comp[i]/C)*len - sv;
+                        long d = du*du + dv*dv;
+                        if(d<bestd){ bestd=d; best=comp[i]; }
+                    }
+
+                    Coord p = face_cell(a, along,   lo[ua]+best%C, lo[va]+best/C);
+                    Coord q = face_cell(a, along+1, lo[ua]+best%C, lo[va]+best/C);
+                    int np = node_for_cell(idx3(p.x,p.y,p.z));
+                    int nq = node_for_cell(idx3(q.x,q.y,q.z));
+                    add_edge(np, nq, 1);
+                    add_edge(nq, np, 1);
+                }
+        }
+    }
+
+    free(mark); free(stack); free(comp);
+}
+
+void hpa_build(void){
+    double t0 = now_ms();
+    hpa_free();
+
+    C   = config.hpa_cluster;
+    ncx = (config.grid_x+C-1)/C;
+    ncy = (config.grid_y+C-1)/C;
+    ncz = (config.grid_z+C-1)/C;
+    ncl = ncx*ncy*ncz;
+
+    P = C+2;
+    l_off[0]=1; l_off[1]=-1; l_off[2]=P; l_off[3]=-P; l_off[4]=P*P; l_off[5]=-P*P;
+    box_cl = -1;
+
+    size_t vol = (size_t)P*P*P;
+    l_open  = (unsigned char*)xrealloc(NULL,vol);
+    l_dist  = (int*)xrealloc(NULL,vol*sizeof(int));
+    l_queue = (int*)xrealloc(NULL,vol*sizeof(int));
+    l_dir   = (signed char*)xrealloc(NULL,vol);
+    l_stamp = (unsigned int*)calloc(vol,sizeof(unsigned int));
+    if(!l_stamp){ fprintf(stderr,"alloc failed\n"); exit(1); }
+    l_cur = 0;
+
+    map_alloc(4096);
+    build_entrances();
+
+    // group nodes by cluster
+    cl_first = (int*)calloc((size_t)ncl+1,sizeof(int));
+    cl_nodes = (int*)xrealloc(NULL,(size_t)(num_nodes+1)*sizeof(int));
+    if(!cl_first){ fprintf(stderr,"alloc failed\n"); exit(1); }
+    for(int n=0;n<num_nodes;n++) cl_first[cluster_of(cell_coord(node_cell[n]))+1]++;
+    for(int c=0;c<ncl;c++) cl_first[c+1] += cl_first[c];
+    int *fill = (int*)xrealloc(NULL,(size_t)ncl*sizeof(int));
+    memcpy(fill,cl_first,(size_t)ncl*sizeof(int));
+    for(int n=0;n<num_nodes;n++) cl_nodes[fill[cluster_of(cell_coord(node_cell[n]))]++] = n;
+    free(fill);
+
+    // intra-cluster edges: one BFS per entrance, confined to its cluster
+    for(int c=0;c<ncl;c++){
+        int b=cl_first[c], e=cl_first[c+1];
+        if(e-b<2) continue;
+        load_box(c);
+        for(int i=b;i<e;i++){
+            int u = cl_nodes[i];
+            local_bfs(cell_coord(node_cell[u]), -1, NULL);
+            for(int j=b;j<e;j++){
+                if(j==i) continue;
+                int d = local_dist(cell_coord(node_cell[cl_nodes[j]]));
+                if(d<UNREACHED) add_edge(u, cl_nodes[j], d);
+            }
+        }
+    }
+
+    // edge list -> CSR by source
+    edge_first = (int*)calloc((size_t)num_nodes+1,sizeof(int));
+    int *to   = (int*)xrealloc(NULL,(size_t)(num_edges+1)*sizeof(int));
+    int *cost = (int*)xrealloc(NULL,(size_t)(num_edges+1)*sizeof(int));
+    if(!edge_first){ fprintf(stderr,"alloc failed\n"); exit(1); }
+    for(long i=0;i<num_edges;i++) edge_first[e_from[i]+1]++;
+    for(int n=0;n<num_nodes;n++) edge_first[n+1] += edge_first[n];
+    fill = (int*)xrealloc(NULL,(size_t)(num_nodes+1)*sizeof(int));
+    memcpy(fill,edge_first,(size_t)(num_nodes+1)*sizeof(int));
+    for(long i=0;i<num_edges;i++){
+        int at = fill[e_from[i]]++;
+        to[at]   = edge_to[i];
+        cost[at] = edge_cost[i];
+    }
+    free(fill);
+    free(e_from); free(edge_to); free(edge_cost);
+    e_from = NULL;
+    edge_to = to;
+    edge_cost = cost;
+
+    int slots = num_nodes+2;
+    a_g      = (int*)xrealloc(NULL,(size_t)slots*sizeof(int));
+    a_came   = (int*)xrealloc(NULL,(size_t)slots*sizeof(int));
+    a_gdist  = (int*)xrealloc(NULL,(size_t)slots*sizeof(int));
+    a_closed = (unsigned char*)xrealloc(NULL,(size_t)slots);
+    a_stamp  = (unsigned int*)calloc((size_t)slots,sizeof(unsigned int));
+    if(!a_stamp){ fprintf(stderr,"alloc failed\n"); exit(1); }
+    for(int i=0;i<slots;i++) a_gdist[i] = UNREACHED;
+    a_cur = 0;
+    a_heap_cap = 1024;
+    a_heap = (HeapItem*)xrealloc(NULL,(size_t)a_heap_cap*sizeof(HeapItem));
+
+    stats.built    = 1;
+    stats.clusters = ncl;
+    stats.nodes    = num_nodes;
+    stats.edges    = num_edges;
+    stats.bytes    = (size_t)map_cap*2*sizeof(int)
+                   + (size_t)num_nodes*sizeof(int)*2 + (size_t)(ncl+1)*sizeof(int)
+                   + (size_t)(num_nodes+1)*sizeof(int) + (size_t)num_edges*2*sizeof(int)
+                   + vol*(2*sizeof(int)+2+sizeof(unsigned int))
+                   + (size_t)slots*(4*sizeof(int)+1);
+    stats.build_ms = now_ms()-t0;
+}
+
+static inline int heap_less(HeapItem a, HeapItem b){
+    return a.f<b.f || (a.f==b.f && a.n<b.n);
+}
+
+static void heap_push(int f, int g, int n){
+    if(a_heap_len==a_heap_cap){
+        a_heap_cap *= 2;
+        a_heap = (HeapItem*)xrealloc(a_heap,(size_t)a_heap_cap*sizeof(HeapItem));
+    }
+    HeapItem it = {f,g,n};
+    int pos = a_heap_len++;
+    while(pos>0){
+        int parent = (pos-1)/2;
+        if(!heap_less(it, a_heap[parent])) break;
+        a_heap[pos] = a_heap[parent];
+        pos = parent;
+    }
+    a_heap[pos] = it;
+}
+
+static HeapItem heap_pop(void){
+    HeapItem top = a_heap[0];
+    HeapItem it = a_heap[--a_heap_len];
+    int pos = 0;
+    while(1){
+        int c = 2*pos+1;
+        if(c>=a_heap_len) break;
+        if(c+1<a_heap_len && heap_less(a_heap[c+1], a_heap[c])) c++;
+        if(!heap_less(a_heap[c], it)) break;
+        a_heap[pos] = a_heap[c];
+        pos = c;
+    }
+    if(a_heap_len>0) a_heap[pos] = it;
+    return top;
+}
+
+// Lazy reset: a slot is live for this query only if its stamp matches.
+static inline int slot_g(int n){
+    return (a_stamp[n]==a_cur) ? a_g[n] : UNREACHED;
+}
+
+static inline void relax(int from, int n, int g, int h){
+    if(g>=slot_g(n)) return;
+    if(a_stamp[n]!=a_cur){ a_stamp[n]=a_cur; a_closed[n]=0; }
+    if(a_closed[n]) return;
+    a_g[n] = g;
+    a_came[n] = from;
+    heap_push(g+h, g, n);
+}
+
+// Copy the refined path out, keeping the first max_len cells like trace_back.
+static int finish_path(Coord *out, int *out_len, int max_len){
+    int n = (plen<max_len) ? plen : max_len;
+    memcpy(out, pbuf, (size_t)n*sizeof(Coord));
+    *out_len = n;
+    return 1;
+}
+
+int hpa_search(Coord start, Coord goal, Coord *out, int *out_len, int max_len, long *expanded){
+    if(!stats.built) hpa_build();
+
+    plen = 0;
+    path_reserve(1);
+    pbuf[plen++] = start;
+
+    int sc = cluster_of(start), gc = cluster_of(goal);
+    if(sc==gc){
+        load_box(sc);
+        if(local_bfs(start, local_index(goal), expanded)){
+            append_local(goal);
+            return finish_path(out, out_len, max_len);
+        }
+    }
+
+    int S = num_nodes, G = num_nodes+1;
+    if(++a_cur==0){
+        memset(a_stamp,0,(size_t)(num_nodes+2)*sizeof(unsigned int));
+        a_cur = 1;
+    }
+    a_heap_len = 0;
+
+    // goal side: which entrances of the goal's cluster reach it, and at what cost
+    load_box(gc);
+    local_bfs(goal, -1, expanded);
+    for(int i=cl_first[gc];i<cl_first[gc+1];i++){
+        int n = cl_nodes[i];
+        a_gdist[n] = local_dist(cell_coord(node_cell[n]));
+    }
+
+    a_stamp[S]=a_cur; a_closed[S]=0; a_g[S]=0; a_came[S]=-1;
+    heap_push(manhattan(start,goal), 0, S);
+
+    int found = 0;
+    while(a_heap_len>0){
+        HeapItem it = heap_pop();
+        int u = it.n;
+        if(a_closed[u] || it.g>a_g[u]) continue;
+        if(u==G){ found = 1; break; }
+        a_closed[u] = 1;
+        (*expanded)++;
+
+        if(u==S){
+            load_box(sc);
+            local_bfs(start, -1, expanded);
+            for(int i=cl_first[sc];i<cl_first[sc+1];i++){
+                int n = cl_nodes[i];
+                int d = local_dist(cell_coord(node_cell[n]));
+                if(d<UNREACHED) relax(S, n, d, manhattan(cell_coord(node_cell[n]),goal));
+            }
+            continue;
+        }
+
+        for(int e=edge_first[u];e<edge_first[u+1];e++){
+            int v = edge_to[e];
+            relax(u, v, a_g[u]+edge_cost[e], manhattan(cell_coord(node_cell[v]),goal));
+        }
+        if(a_gdist[u]<UNREACHED) relax(u, G, a_g[u]+a_gdist[u], 0);
+    }
+
+    for(int i=cl_first[gc];i<cl_first[gc+1];i++) a_gdist[cl_nodes[i]] = UNREACHED;
+    if(!found) return 0;
+
+    // abstract path G -> S, reversed in place over a_g (no longer needed)
+    int len=0;
+    for(int n=a_came[G]; n!=S; n=a_came[n]) a_g[len++] = n;
+
+    Coord cur = start;
+    for(int i=len;i>=0;i--){
+        Coord t = (i>0) ? cell_coord(node_cell[a_g[i-1]]) : goal;
+        if(cluster_of(t)!=cluster_of(cur)){
+            // edge across a face: t is the neighbouring cell
+            path_reserve(1);
+            pbuf[plen++] = t;
+        } else {
+            load_box(cluster_of(cur));
+            local_bfs(cur, local_index(t), expanded);
+            append_local(t);
+        }
+        cur = t;
+    }
+
+    return finish_path(out, out_len, max_len);
+}
+
+void hpa_get_stats(HPAStats *out){
+    *out = stats;
+}
+
+void hpa_free(void){
+    free(node_cell); free(cl_first); free(cl_nodes);
+    free(edge_first); free(edge_to); free(edge_cost); free(e_from);
+    free(map_cell); free(map_node);
+    free(l_open); free(l_dist); free(l_queue); free(l_dir); free(l_stamp);
+    free(a_g); free(a_came); free(a_gdist); free(a_closed); free(a_stamp); free(a_heap);
+    free(pbuf);
+    node_cell = cl_first = cl_nodes = NULL;
+    edge_first = edge_to = edge_cost = e_from = NULL;
+    map_cell = map_node = NULL;
+    l_dist = l_queue = NULL; l_open = NULL; l_dir = NULL; l_stamp = NULL;
+    a_g = a_came = a_gdist = NULL; a_closed = NULL; a_stamp = NULL; a_heap = NULL;
+    pbuf = NULL;
+    num_nodes = nodes_cap = 0;
+    num_edges = edges_cap = 0;
+    map_cap = 0;
+    box_cl = -1;
+    a_heap_len = a_heap_cap = 0;
+    plen = pcap = 0;
+    memset(&stats,0,sizeof(stats));
+}
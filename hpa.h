@@ -0,0 +1,29 @@
+#ifndef HPA_H
+#define HPA_H
+
+#include "types.h"
+
+// Hierarchical pathfinding (HPA*). The grid is cut into hpa_cluster^3
+// blocks; every free run across a block face becomes one entrance, and the
+// cost between entrances of a block is found by BFS inside it. hpa_build
+// does this once after init_grid, a query then searches the entrance graph
+// and refines the result block by block. Paths are near-optimal.
+void hpa_build(void);
+
+// Same contract as the other baseline searches: fills out[] start..goal.
+int  hpa_search(Coord start, Coord goal, Coord *out, int *out_len, int max_len, long *expanded);
+
+typedef struct {
+    int    built;
+    int    clusters;
+    int    nodes;            // entrance cells
+    long   edges;            // directed, including the edges across faces
+    size_t bytes;            // abstract graph and search arrays
+    double build_ms;
+} HPAStats;
+
+void hpa_get_stats(HPAStats *out);
+
+void hpa_free(void);
+
+#endif
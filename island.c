@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "island.h"
+#include "pool.h"
+#include "config.h"
+#include "genome.h"
+
+typedef struct {
+    atomic_uint head;   // next slot the producer fills
+    char        pad0[64 - sizeof(atomic_uint)];
+    atomic_uint tail;   // next slot the consumer takes
+    char        pad1[64 - sizeof(atomic_uint)];
+    Path       *slots;
+} MigRing;
+
+typedef struct {
+    atomic_long sent;
+    atomic_long dropped;
+} MigCounters;
+
+// Set up by island_attach before the fork, inherited by the workers.
+static MigCounters *counters;
+static MigRing     *rings;
+static int         *edge_off;   // rings of worker w: edge_off[w] .. edge_off[w+1]-1
+
+static int migrating(void) {
+    return config.migration_interval > 0 && config.num_processes > 1 &&
+           strcmp(config.backend, "processes") == 0;
+}
+
+// Two migrations' worth, so a fast producer never finds the ring full.
+static int ring_cap(void) {
+    int r = 4;
+    while (r < 2 * config.migration_count) r <<= 1;
+    return r;
+}
+
+static int torus_rows(int n) {
+    int rows = 1;
+    for (int r = 1; r * r <= n; r++)
+        if (n % r == 0) rows = r;
+    return rows;
+}
+
+// Out-neighbours of worker w in ascending order; returns their count.
+static int neighbours(int w, int *out) {
+    int n = config.num_processes;
+    int k = 0;
+    if (strcmp(config.migration_topology, "full") == 0) {
+        for (int j = 0; j < n; j++)
+            if (j != w) out[k++] = j;
+        return k;
+    }
+    if (strcmp(config.migration_topology, "torus") == 0) {
+        int rows = torus_rows(n), cols = n / rows;
+        int r = w / cols, c = w % cols;
+        int cand[4] = { r * cols + (c + 1) % cols, r * cols + (c + cols - 1) % cols,
+                        ((r + 1) % rows) * cols + c, ((r + rows - 1) % rows) * cols + c };
+        // small grids wrap onto the same neighbour twice, or onto w itself
+        for (int i = 0; i < 4; i++) {
+            int dup = (cand[i] == w);
+            for (int j = 0; j < k && !dup; j++) dup = (out[j] == cand[i]);
+            if (!dup) out[k++] = cand[i];
+        }
+        for (int i = 1; i < k; i++)
+            for (int j = i; j > 0 && out[j - 1] > out[j]; j--) {
+                int t = out[j]; out[j] = out[j - 1]; out[j - 1] = t;
+            }
+        return k;
+    }
+    out[k++] = (w + 1) % n;  // ring
+    return k;
+}
+
+static int num_edges(void) {
+    int n = config.num_processes, e = 0;
+    int tmp[n];
+    for (int w = 0; w < n; w++) e += neighbours(w, tmp);
+    return e;
+}
+
+size_t island_shared_bytes(void) {
+    if (!migrating()) return 0;
+    size_t e = (size_t)num_edges();
+    return sizeof(MigCounters) + e * sizeof(MigRing) +
+           e * (size_t)ring_cap() * (sizeof(Path) + genome_bytes(config.max_path_length));
+}
+
+char *island_attach(char *ptr) {
+    if (!migrating()) return ptr;
+    int n = config.num_processes, cap = ring_cap();
+
+    counters = (MigCounters *)ptr;
+    ptr += sizeof(MigCounters);
+    atomic_init(&counters->sent, 0);
+    atomic_init(&counters->dropped, 0);
+
+    edge_off = (int *)malloc((size_t)(n + 1) * sizeof(int));
+    if (!edge_off) { fprintf(stderr, "alloc failed\n"); exit(1); }
+    int tmp[n];
+    edge_off[0] = 0;
+    for (int w = 0; w < n; w++) edge_off[w + 1] = edge_off[w] + neighbours(w, tmp);
+
+    int e = edge_off[n];
+    rings = (MigRing *)ptr;
+    ptr += (size_t)e * sizeof(MigRing);
+    for (int i = 0; i < e; i++) {
+        atomic_init(&rings[i].head, 0);
+        atomic_init(&rings[i].tail, 0);
+        rings[i].slots = (Path *)ptr;
+        ptr += (size_t)cap * sizeof(Path);
+    }
+    for (int i = 0; i < e; i++)
+        ptr = genome_bind(rings[i].slots, cap, config.max_path_length, ptr);
+    return ptr;
+}
+
+int island_due(int local_gen) {
+    if (!migrating()) return 0;
+    int every = config.migration_interval;
+    // generational exchanges happen at barriers, so round the interval up to one
+    if (strcmp(config.ga_mode, "steady") != 0)
+        every = (every + GENS_PER_BARRIER - 1) / GENS_PER_BARRIER * GENS_PER_BARRIER;
+    return local_gen % every == 0;
+}
+
+static int migrants(int N) {
+    return (config.migration_count < N) ? config.migration_count : N - 1;
+}
+
+void island_emigrate(int worker, const Path *pop, int N) {
+    int k = migrants(N);
+    if (k <= 0) return;
+
+    // best k by fitness, ties to the lower index
+    int pick[k];
+    for (int m = 0; m < k; m++) {
+        int b = -1;
+        for (int i = 0; i < N; i++) {
+            int taken = 0;
+            for (int j = 0; j < m && !taken; j++) taken = (pick[j] == i);
+            if (!taken && (b < 0 || pop[i].fitness > pop[b].fitness)) b = i;
+        }
+        pick[m] = b;
+    }
+
+    unsigned mask = (unsigned)ring_cap() - 1;
+    for (int e = edge_off[worker]; e < edge_off[worker + 1]; e++) {
+        MigRing *r = &rings[e];
+        for (int m = 0; m < k; m++) {
+            unsigned h = atomic_load_explicit(&r->head, memory_order_relaxed);
+            unsigned t = atomic_load_explicit(&r->tail, memory_order_acquire);
+            if (h - t > mask) { atomic_fetch_add(&counters->dropped, 1); continue; }
+            genome_copy(&r->slots[h & mask], &pop[pick[m]]);
+            atomic_store_explicit(&r->head, h + 1, memory_order_release);
+            atomic_fetch_add(&counters->sent, 1);
+        }
+    }
+}
+
+static int replace_slot(const Path *pop, int N, Rng *rng) {
+    if (strcmp(config.migration_replace, "random") == 0) {
+        int best = 0;
+        for (int i = 1; i < N; i++)
+            if (pop[i].fitness > pop[best].fitness) best = i;
+        int i = rng_below(rng, N);
+        return (i == best) ? (i + 1) % N : i;
+    }
+    int worst = N - 1;
+    for (int i = N - 2; i >= 0; i--)
+        if (pop[i].fitness < pop[worst].fitness) worst = i;
+    return worst;
+}
+
+void island_immigrate(int worker, Path *pop, int N, Rng *rng) {
+    int k = migrants(N);
+    if (k <= 0) return;
+    int n = config.num_processes;
+    unsigned mask = (unsigned)ring_cap() - 1;
+    int out[n];
+
+    for (int src = 0; src < n; src++) {
+        int cnt = neighbours(src, out);
+        for (int j = 0; j < cnt; j++) {
+            if (out[j] != worker) continue;
+            MigRing *r = &rings[edge_off[src] + j];
+            // exactly one migration's worth: later ones belong to the next exchange
+            for (int m = 0; m < k; m++) {
+                unsigned t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+                unsigned h = atomic_load_explicit(&r->head, memory_order_acquire);
+                if (t == h) break;
+                genome_copy(&pop[replace_slot(pop, N, rng)], &r->slots[t & mask]);
+                atomic_store_explicit(&r->tail, t + 1, memory_order_release);
+            }
+        }
+    }
+}
+
+void island_get_counts(long *sent, long *dropped) {
+    *sent = counters ? atomic_load(&counters->sent) : 0;
+    *dropped = counters ? atomic_load(&counters->dropped) : 0;
+}
@@ -0,0 +1,34 @@
+#ifndef ISLAND_H
+#define ISLAND_H
+
+#include <stddef.h>
+
+#include "types.h"
+#include "rng.h"
+
+// Island migration for the process backend. Every directed edge of the
+// topology (config.migration_topology) gets a single-producer/single-
+// consumer ring of genomes in shared memory:
+//  - ring:  worker i -> i+1
+//  - torus: workers on a rows x cols grid (rows = largest divisor of n up
+//           to sqrt(n)), each sending to its four wrap-around neighbours
+//  - full:  every worker -> every other worker
+// Workers emigrate their best migration_count paths just before a
+// generation barrier and take in exactly that many per incoming edge just
+// after it, so the exchange does not depend on timing and seeded runs stay
+// reproducible. With ga_mode=steady there is no barrier: a worker sends
+// and then takes whatever has arrived, and a full ring drops the migrant.
+
+size_t island_shared_bytes(void);
+char  *island_attach(char *ptr);
+
+// 1 if worker processes should migrate at this local generation.
+int  island_due(int local_gen);
+
+void island_emigrate(int worker, const Path *pop, int N);
+void island_immigrate(int worker, Path *pop, int N, Rng *rng);
+
+// Migrants sent, and dropped because a ring was full (should stay 0).
+void island_get_counts(long *sent, long *dropped);
+
+#endif
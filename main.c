@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <time.h>
 #include <sys/wait.h>
@@ -8,6 +9,15 @@
 #include "pool.h"
 #include "genetic.h"
 #include "astar.h"
+#include "tour.h"
+#include "hpa.h"
+#include "grid.h"
+#include "genome.h"
+#include "rng.h"
+#include "snapshot.h"
+#include "tpool.h"
+#include "island.h"
+#include "telemetry.h"
 
 static StartMode ask_start_mode(void){
     printf("Choose robot starting position:\n");
@@ -32,28 +42,28 @@ static double now_sec(void){
 static int is_edge(int x,int y,int z){
     return (x==0 || x==config.grid_x-1 || y==0 || y==config.grid_y-1 || z==0 || z==config.grid_z-1);
 }
-static Coord pick_start_for_baseline(StartMode m){
+static Coord pick_start_for_baseline(StartMode m,Rng *rng){
     Coord c;
     if(m==START_TOP){
         do{
-            c.x=rand()%config.grid_x;
-            c.y=rand()%config.grid_y;
+            c.x=rng_below(rng,config.grid_x);
+            c.y=rng_below(rng,config.grid_y);
             c.z=config.grid_z-1;
         }while(get_cell(c)==OBSTACLE);
         return c;
     }
     if(m==START_EDGES){
         do{
-            c.x=rand()%config.grid_x;
-            c.y=rand()%config.grid_y;
-            c.z=rand()%config.grid_z;
+            c.x=rng_below(rng,config.grid_x);
+            c.y=rng_below(rng,config.grid_y);
+            c.z=rng_below(rng,config.grid_z);
         }while(!is_edge(c.x,c.y,c.z) || get_cell(c)==OBSTACLE);
         return c;
     }
     do{
-        c.x=rand()%config.grid_x;
-        c.y=rand()%config.grid_y;
-        c.z=rand()%config.grid_z;
+        c.x=rng_below(rng,config.grid_x);
+        c.y=rng_below(rng,config.grid_y);
+        c.z=rng_below(rng,config.grid_z);
     }while(get_cell(c)==OBSTACLE);
     return c;
 }
@@ -63,74 +73,174 @@ int main(int argc,char **argv){
     read_config(cfg);
     print_config();
 
-    g_start_mode = ask_start_mode();
+    g_start_mode = config.start_mode ? (StartMode)config.start_mode : ask_start_mode();
     printf("✅ Start mode selected: %d\n\n", (int)g_start_mode);
 
-    srand((unsigned int)time(NULL));
+    if (config.seed == 0) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        config.seed = ((unsigned long long)ts.tv_sec << 20) ^ (unsigned long long)ts.tv_nsec;
+        printf("Seed: %llu (replay with seed=%llu)\n\n", config.seed, config.seed);
+    }
+    // stream 0: grid, initial population and baseline start; workers use 1..n
+    Rng rng;
+    rng_seed(&rng, config.seed, 0);
 
     init_shared_memory();
-    init_grid();
-    init_population(shared->population);
+    init_grid(&rng);
+    if (strcmp(config.astar_mode, "hpa") == 0) hpa_build();
+
+    GridStats gs;
+    grid_get_stats(&gs);
+    if (gs.chunked) {
+        printf("Grid: chunked | %d chunks, %d uniform, %d bricks (obstacles per brick: mean %.1f, max %d) | %.1f MB (dense: %.1f MB)\n\n",
+               gs.chunks, gs.uniform, gs.bricks, gs.mean_obstacles, gs.max_obstacles,
+               (double)gs.bytes / 1048576.0, (double)gs.dense_bytes / 1048576.0);
+    } else {
+        printf("Grid: dense | %.1f MB\n\n", (double)gs.bytes / 1048576.0);
+    }
+
+    FitnessScratch scratch;
+    scratch_init(&scratch);
+    init_population(shared->population, &scratch, &rng);
 
     // ---- A* baseline timing (comparison only) ----
-    Coord baseline_start = pick_start_for_baseline(g_start_mode);
-    Path astar_path;
+    Coord baseline_start = pick_start_for_baseline(g_start_mode, &rng);
+    Path *astar_path = genome_alloc(1, genome_max_cells());
 
     double t0_astar = now_sec();
-    astar_build_baseline(&astar_path, baseline_start);
+    astar_build_baseline(astar_path, baseline_start, &scratch);
     double t1_astar = now_sec();
 
-    write_astar_file("robot_data_astar.txt", &astar_path);
+    AStarStats astar_stats;
+    astar_get_stats(&astar_stats);
+
+    write_astar_file("robot_data_astar.txt", astar_path);
 
     printf("=== A* Baseline (comparison only) ===\n");
     printf("A* time: %.6f sec\n", (t1_astar - t0_astar));
-    printf("A* fitness: %.2f | length: %d | unique survivors: %d | priority sum: %d | coverage: %d\n\n",
-           astar_path.fitness, astar_path.length, astar_path.survivors_reached, astar_path.priority_sum, astar_path.coverage);
+    printf("A* fitness: %.2f | length: %d | unique survivors: %d | priority sum: %d | coverage: %d\n",
+           astar_path->fitness, astar_path->length, astar_path->survivors_reached, astar_path->priority_sum, astar_path->coverage);
+    if (strcmp(config.baseline_order, "tour") == 0) {
+        TourStats ts;
+        tour_get_stats(&ts);
+        printf("Tour: %d reachable survivors | %s | BFS %.3f ms on %d threads%s | solve %.3f ms | cost %.1f | steps %ld\n",
+               ts.reachable, ts.exact ? "Held-Karp" : "insertion + 2-opt/Or-opt",
+               ts.bfs_ms, ts.threads, ts.fields_kept ? "" : " (fields re-run per leg)",
+               ts.solve_ms, ts.cost, ts.total_steps);
+    } else {
+        if (strcmp(config.astar_mode, "hpa") == 0) {
+            // HPA* searches its own graph, never the node storage
+            HPAStats hs;
+            hpa_get_stats(&hs);
+            printf("A* nodes: expanded: %ld | HPA* graph memory: %.1f KB\n",
+                   astar_stats.expanded, (double)hs.bytes / 1024.0);
+            printf("HPA*: %d clusters | %d entrances | %ld edges | built in %.3f ms\n",
+                   hs.clusters, hs.nodes, hs.edges, hs.build_ms);
+        } else {
+            printf("A* nodes: %s storage | expanded: %ld | peak node memory: %.1f KB\n",
+                   astar_stats.sparse ? "sparse" : "dense", astar_stats.expanded,
+                   (double)astar_stats.peak_node_bytes / 1024.0);
+        }
+        for (int i = 0; i < astar_stats.num_segments; i++) {
+            const AStarSegment *sg = &astar_stats.segments[i];
+            printf("  leg %2d -> survivor %d: %s len=%d expanded=%ld time=%.3f ms",
+                   i + 1, sg->survivor, sg->found ? "ok" : "unreachable", sg->length, sg->expanded, sg->ms);
+            if (sg->improvements > 0) printf(" solutions=%d", sg->improvements);
+            printf("\n");
+        }
+    }
+    printf("\n");
+    if (config.target_set == 2) config.target_fitness = astar_path->fitness;
+    astar_free_workspace();
+    free(astar_path);
 
     // ---- GA run timing ----
+    int threads = (strcmp(config.backend, "threads") == 0);
+    // steady: shared->generation counts GENS_PER_BARRIER x population_size
+    // evaluations, the work of one barrier round in generational mode
+    int steady = (strcmp(config.ga_mode, "steady") == 0);
     pid_t pids[config.num_processes];
-    create_process_pool(pids);
+    if (threads) tpool_start();
+    else create_process_pool(pids);
+    snapshot_start();  // after the fork: workers must not inherit the thread
+    telemetry_open();
 
     int snapshot_interval = 20;
     int next_snapshot = snapshot_interval;
     int snap_count = 0;
 
-    double t0_ga = now_sec();
-    time_t start_wall = time(NULL);
+    // both count from just before the workers were started
+    double t0_ga = shared->ga_start_ms / 1e3;
+    double deadline_ms = config.deadline_ms > 0 ? shared->ga_start_ms + config.deadline_ms : 0;
+    double deadline_late_ms = -1, deadline_read_ms = 0;
+    Path *deadline_best = genome_alloc(1, config.max_path_length);
 
     double last_best = -1e18;
     int stagn = 0;
+    int last_improved_gen = 0;
     int last_seen_gen = -1;
 
+    double wake_sum = 0, wake_max = 0;
+    int wakes = 0;
+
     while(1){
-        lock_sem();
-        int gen = shared->generation;
-        double best = shared->best_fitness;
-        int stop = shared->stop_flag;
-        unlock_sem();
+        unsigned seq = pool_event_seq();  // before the checks, so no event slips between
+        int gen = atomic_load(&shared->generation);
+        int stop = atomic_load(&shared->stop_flag);
+        double best = pool_best_fitness();
 
         if(stop) break;
         if(gen >= config.num_generations) break;
 
+        // a worker that dies would leave the others in the barrier for good
+        pid_t dead = waitpid(-1, NULL, WNOHANG);
+        if(dead>0 && atomic_load(&shared->generation) < config.num_generations){
+            printf("\n⏹️  Stopping: worker %d exited early\n", (int)dead);
+            pool_request_stop();
+            break;
+        }
+
+        double now = now_sec() * 1e3;
+        if(deadline_ms > 0 && now >= deadline_ms){
+            // the published best is readable without waiting for anyone
+            pool_request_stop();
+            deadline_late_ms = now - deadline_ms;
+            pool_read_best(deadline_best);
+            deadline_read_ms = now_sec() * 1e3 - deadline_ms;
+            // report it now: the result must not depend on the workers
+            // getting through their last barrier
+            printf("\n⏹️  Stopping: deadline reached (%d ms, best=%.2f)\n", config.deadline_ms, deadline_best->fitness);
+            printf("Deadline result: fitness %.2f | path length %d | survivors %d | priority sum %d | in hand %.3f ms after the deadline\n",
+                   deadline_best->fitness, deadline_best->length, deadline_best->survivors_reached,
+                   deadline_best->priority_sum, deadline_read_ms);
+            fflush(stdout);
+            break;
+        }
+
+        if(config.time_limit_seconds>0 && now_sec() - t0_ga >= config.time_limit_seconds){
+            printf("\n⏹️  Stopping: time limit reached (%d sec)\n", config.time_limit_seconds);
+            pool_request_stop();
+            break;
+        }
+
+        telemetry_drain();
+
         if(gen != last_seen_gen){
             last_seen_gen = gen;
 
             if(config.stagnation_limit>0){
-                if(best <= last_best + 1e-6) stagn++;
-                else { stagn=0; last_best=best; }
+                // steady: generations are evaluation counts, so measure the gap
+                if(best > last_best + 1e-6){ stagn=0; last_best=best; last_improved_gen=gen; }
+                else stagn = steady ? gen - last_improved_gen : stagn + 1;
 
                 if(stagn >= config.stagnation_limit){
-                    printf("\n⏹️  Stopping: stagnation reached (%d generations)\n", config.stagnation_limit);
-                    lock_sem(); shared->stop_flag=1; unlock_sem();
-                    break;
-                }
-            }
-
-            if(config.time_limit_seconds>0){
-                time_t now = time(NULL);
-                if((int)difftime(now, start_wall) >= config.time_limit_seconds){
-                    printf("\n⏹️  Stopping: time limit reached (%d sec)\n", config.time_limit_seconds);
-                    lock_sem(); shared->stop_flag=1; unlock_sem();
+                    if(steady)
+                        printf("\n⏹️  Stopping: stagnation reached (%ld evaluations)\n",
+                               (long)config.stagnation_limit * GENS_PER_BARRIER * config.population_size);
+                    else
+                        printf("\n⏹️  Stopping: stagnation reached (%d generations)\n", config.stagnation_limit);
+                    pool_request_stop();
                     break;
                 }
             }
@@ -139,7 +249,7 @@ int main(int argc,char **argv){
                 snap_count++;
                 printf("\n📸 Saving snapshot %d at global generation %d (best=%.2f)\n",
                        snap_count, gen, best);
-                lock_sem(); write_data_file(snap_count); unlock_sem();
+                snapshot_request(snap_count, gen);
                 next_snapshot += snapshot_interval;
             }
 
@@ -148,16 +258,27 @@ int main(int argc,char **argv){
             }
         }
 
-        usleep(100000);
+        // sleep until a worker moves the generation or exits; the cap only
+        // matters for a worker that dies without notifying
+        double wait_ms = 100;
+        if(deadline_ms > 0 && deadline_ms - now < wait_ms) wait_ms = deadline_ms - now;
+        if(pool_wait_event(seq, wait_ms)){
+            double lag = now_sec() * 1e3 - shared->event_ms;
+            wake_sum += lag;
+            if(lag > wake_max) wake_max = lag;
+            wakes++;
+        }
     }
 
-    // final snapshot
-    lock_sem();
-    snap_count++;
-    write_data_file(snap_count);
-    unlock_sem();
+    if (threads) tpool_join();
+    else wait_for_workers(pids);
+    double joined_ms = now_sec() * 1e3 - deadline_ms;
+    telemetry_close();
 
-    wait_for_workers(pids);
+    // final snapshot, once every worker has published its last best
+    snap_count++;
+    snapshot_request(snap_count, atomic_load(&shared->generation));
+    snapshot_stop();
 
     double t1_ga = now_sec();
 
@@ -169,9 +290,69 @@ int main(int argc,char **argv){
     printf("Priority sum reached: %d\n", shared->best_path.priority_sum);
     printf("Coverage (cells): %d\n", shared->best_path.coverage);
 
+    long lookups = shared->cache_hits + shared->cache_misses;
+    printf("Fitness evaluations: %ld | unchanged copies skipped: %ld | cache hits: %ld/%ld (%.1f%%)\n",
+           shared->evals, shared->evals_skipped, shared->cache_hits, lookups,
+           lookups ? 100.0 * (double)shared->cache_hits / (double)lookups : 0.0);
+    // a generation evolves the whole population (threads) or one worker's
+    // sub-population (processes), GENS_PER_BARRIER per shared generation;
+    // steady counts each population_size evaluations as one
+    int gens = threads ? 0 : GENS_PER_BARRIER * atomic_load(&shared->generation);
+    if (steady) {
+        long evals = atomic_load(&shared->evaluations);
+        gens = (int)(evals / config.population_size);
+        printf("Steady state: %ld evaluations, %ld children inserted (replace %s)\n",
+               evals, shared->steady_inserted, config.steady_replace);
+    }
+    if (threads) {
+        TPoolStats tp;
+        tpool_get_stats(&tp);
+        gens = tp.generations;
+        printf("Work stealing: %ld tasks of %d children, %ld stolen\n", tp.tasks, TPOOL_CHUNK, tp.stolen);
+    }
+    long children = shared->evals + shared->evals_skipped + shared->cache_hits;
+    printf("Throughput (%s, %d workers): %.1f generations/sec | %.0f children/sec\n",
+           config.backend, config.num_processes,
+           (double)gens / (t1_ga - t0_ga), (double)children / (t1_ga - t0_ga));
+    if (config.migration_interval > 0 && !threads) {
+        long sent, dropped;
+        island_get_counts(&sent, &dropped);
+        printf("Migration: %ld paths sent (%s, every %d generations), %ld dropped\n",
+               sent, config.migration_topology, config.migration_interval, dropped);
+    }
+    if (config.target_set) {
+        if (shared->target_ms >= 0)
+            printf("Time to target fitness %.2f: %.3f sec (generation %d)\n",
+                   config.target_fitness, shared->target_ms / 1000.0, shared->target_gen);
+        else
+            printf("Time to target fitness %.2f: not reached\n", config.target_fitness);
+    }
+    if (!steady) {
+        printf("Barrier wait (ms per worker):");
+        for (int i = 0; i < config.num_processes; i++) printf(" %.1f", shared->wait_ms[i]);
+        printf("\n");
+    }
+
+    if (telemetry_on()) {
+        long written, dropped;
+        telemetry_get_counts(&written, &dropped);
+        printf("Telemetry: %ld records to %s, %ld dropped\n", written, config.telemetry_file, dropped);
+    }
+    if (wakes > 0)
+        printf("Supervisor: %d wake-ups, latency mean %.3f ms, max %.3f ms\n",
+               wakes, wake_sum / wakes, wake_max);
+    if (deadline_late_ms >= 0)
+        printf("Deadline %d ms: noticed %.3f ms late, best (%.2f) in hand after %.3f ms, workers stopped after %.3f ms\n",
+               config.deadline_ms, deadline_late_ms, deadline_best->fitness, deadline_read_ms, joined_ms);
+
+    if (threads) printf("Peak RSS: %ld KB\n", pool_peak_rss_kb());
+    else printf("Peak RSS: main %ld KB | largest worker %ld KB\n", pool_peak_rss_kb(), shared->worker_rss_kb);
+
     printf("\n=== Time Comparison ===\n");
     printf("A* time: %.6f sec | GA time: %.6f sec\n", (t1_astar - t0_astar), (t1_ga - t0_ga));
 
+    free(deadline_best);
+    scratch_free(&scratch);
     cleanup_shared_memory();
     return 0;
 }
@@ -0,0 +1,283 @@
+// Microbenchmarks of the GA hot paths on synthetic grids.
+//
+//   ./rescue_microbench [min_ms]
+//
+// Every grid in the table below runs in its own forked process (the grid,
+// fitness fields and A* workspace are process globals), with the fitness
+// cache off so calculate_fitness always runs the kernel. Each operation is
+// repeated for at least min_ms (default 200) and reports ns/op, heap bytes
+// and allocations per op (malloc/calloc/realloc are wrapped at link time,
+// see the Makefile) and cycles per gene: CPU cycles from perf_event_open,
+// or the time-stamp counter where perf is unavailable.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "config.h"
+#include "pool.h"
+#include "genetic.h"
+#include "astar.h"
+#include "hpa.h"
+#include "genome.h"
+#include "rng.h"
+
+typedef struct {
+    const char *name;
+    int    x, y, z;
+    double density;     // obstacle fraction of the cells
+    int    survivors;
+} BenchGrid;
+
+static const BenchGrid grids[] = {
+    { "small",  32,  32,  8, 0.05, 10 },
+    { "dense",  64,  64, 16, 0.30, 20 },
+    { "large", 256, 256, 32, 0.02, 40 },
+};
+
+// ---- allocation counters (ld --wrap) ----
+
+void *__real_malloc(size_t n);
+void *__real_calloc(size_t n, size_t m);
+void *__real_realloc(void *p, size_t n);
+
+static long alloc_bytes, alloc_calls;
+
+void *__wrap_malloc(size_t n) {
+    alloc_bytes += (long)n; alloc_calls++;
+    return __real_malloc(n);
+}
+void *__wrap_calloc(size_t n, size_t m) {
+    alloc_bytes += (long)(n * m); alloc_calls++;
+    return __real_calloc(n, m);
+}
+void *__wrap_realloc(void *p, size_t n) {
+    alloc_bytes += (long)n; alloc_calls++;
+    return __real_realloc(p, n);
+}
+
+// ---- cycle counter ----
+
+static int perf_fd = -1;
+
+static void cycles_open(void) {
+    struct perf_event_attr pe;
+    memset(&pe, 0, sizeof(pe));
+    pe.type = PERF_TYPE_HARDWARE;
+    pe.size = sizeof(pe);
+    pe.config = PERF_COUNT_HW_CPU_CYCLES;
+    pe.exclude_kernel = 1;
+    pe.exclude_hv = 1;
+    perf_fd = (int)syscall(SYS_perf_event_open, &pe, 0, -1, -1, 0);
+}
+
+static const char *cycles_source(void) {
+    if (perf_fd >= 0) return "perf cycles";
+#if defined(__x86_64__) || defined(__i386__)
+    return "tsc, perf_event_open unavailable";
+#else
+    return "none, perf_event_open unavailable";
+#endif
+}
+
+static unsigned long long cycles_now(void) {
+    if (perf_fd >= 0) {
+        unsigned long long v = 0;
+        if (read(perf_fd, &v, sizeof(v)) == sizeof(v)) return v;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// ---- harness ----
+
+typedef struct {
+    Rng   rng;
+    FitnessScratch scratch;
+    Path *pool;         // BENCH_POOL random paths
+    Path *child;
+    Path *pop, *next;   // population_size each
+    Coord *ends;        // BENCH_POOL (start, goal) pairs for A*
+    Coord *leg;
+    int   leg_cap;
+} Ctx;
+
+#define BENCH_POOL 64
+
+typedef long (*BenchOp)(Ctx *c, long i);   // returns genes touched
+
+static double min_ns = 200e6;
+
+static void run(const char *name, BenchOp op, Ctx *c) {
+    op(c, 0);  // warm up: first-touch allocations do not count
+
+    long ops = 0, genes = 0;
+    long b0 = alloc_bytes, a0 = alloc_calls;
+    unsigned long long k0 = cycles_now();
+    double t0 = now_ns(), t1;
+    do {
+        for (int r = 0; r < 16; r++, ops++) genes += op(c, ops);
+        t1 = now_ns();
+    } while (t1 - t0 < min_ns);
+    unsigned long long k1 = cycles_now();
+
+    printf("  %-24s %12.0f %10.1f %9.2f %10.1f %11.2f\n", name,
+           (t1 - t0) / ops,
+           (double)(alloc_bytes - b0) / ops, (double)(alloc_calls - a0) / ops,
+           (double)genes / ops, genes ? (double)(k1 - k0) / genes : 0.0);
+}
+
+static long op_generate(Ctx *c, long i) {
+    Path *p = &c->pool[i % BENCH_POOL];
+    generate_random_path(p, &c->rng);
+    return p->length;
+}
+
+static long op_fitness(Ctx *c, long i) {
+    Path *p = &c->pool[i % BENCH_POOL];
+    calculate_fitness(p, &c->scratch);
+    return p->length;
+}
+
+static long op_astar(Ctx *c, long i) {
+    int k = (int)(i % (BENCH_POOL / 2));
+    int len = 0;
+    AStarSegment seg;
+    memset(&seg, 0, sizeof(seg));
+    astar_one(c->ends[2 * k], c->ends[2 * k + 1], c->leg, &len, c->leg_cap, 1e300, &seg);
+    return len;
+}
+
+static long op_crossover(Ctx *c, long i) {
+    crossover(&c->pool[i % BENCH_POOL], &c->pool[(i * 7 + 3) % BENCH_POOL], c->child, &c->rng);
+    return c->child->length;
+}
+
+static long op_mutate(Ctx *c, long i) {
+    // mutation_rate is 1 here, so every call changes a gene
+    Path *p = &c->pool[i % BENCH_POOL];
+    mutate(p, &c->rng);
+    return p->length;
+}
+
+static long op_evolve(Ctx *c, long i) {
+    (void)i;
+    evolve_population_local(&c->pop, &c->next, config.population_size, &c->scratch, &c->rng);
+    long genes = 0;
+    for (int k = 0; k < config.population_size; k++) genes += c->pop[k].length;
+    return genes;
+}
+
+static Coord random_free(Rng *rng) {
+    Coord c;
+    do {
+        c.x = rng_below(rng, config.grid_x);
+        c.y = rng_below(rng, config.grid_y);
+        c.z = rng_below(rng, config.grid_z);
+    } while (get_cell(c) == OBSTACLE);
+    return c;
+}
+
+static void bench_grid(const BenchGrid *g) {
+    config.grid_x = g->x;
+    config.grid_y = g->y;
+    config.grid_z = g->z;
+    config.num_obstacles = (int)(g->density * g->x * g->y * g->z);
+    config.num_survivors = g->survivors;
+
+    Ctx c;
+    rng_seed(&c.rng, config.seed, 0);
+    init_shared_memory();
+    init_grid(&c.rng);
+    if (strcmp(config.astar_mode, "hpa") == 0) hpa_build();
+    scratch_init(&c.scratch);
+
+    c.pool = genome_alloc(BENCH_POOL, config.max_path_length);
+    c.child = genome_alloc(1, config.max_path_length);
+    c.pop = genome_alloc(config.population_size, config.max_path_length);
+    c.next = genome_alloc(config.population_size, config.max_path_length);
+    for (int i = 0; i < BENCH_POOL; i++) {
+        generate_random_path(&c.pool[i], &c.rng);
+        calculate_fitness(&c.pool[i], &c.scratch);
+    }
+    for (int i = 0; i < config.population_size; i++) {
+        generate_random_path(&c.pop[i], &c.rng);
+        calculate_fitness(&c.pop[i], &c.scratch);
+    }
+    c.ends = (Coord *)malloc(BENCH_POOL * sizeof(Coord));
+    c.leg_cap = 4 * (g->x + g->y + g->z);
+    c.leg = (Coord *)malloc((size_t)c.leg_cap * sizeof(Coord));
+    if (!c.ends || !c.leg) { fprintf(stderr, "alloc failed\n"); exit(1); }
+    for (int i = 0; i < BENCH_POOL; i++) c.ends[i] = random_free(&c.rng);
+
+    printf("\n%s: %dx%dx%d, %.0f%% obstacles, %d survivors, population %d, max_path_length %d\n",
+           g->name, g->x, g->y, g->z, g->density * 100, g->survivors,
+           config.population_size, config.max_path_length);
+    printf("  %-24s %12s %10s %9s %10s %11s\n", "op", "ns/op", "bytes/op", "allocs/op", "genes/op", "cycles/gene");
+    run("generate_random_path", op_generate, &c);
+    run("calculate_fitness", op_fitness, &c);
+    run("astar_one", op_astar, &c);
+    run("crossover", op_crossover, &c);
+    run("mutate", op_mutate, &c);
+    run("evolve_population_local", op_evolve, &c);
+
+    free(c.ends);
+    free(c.leg);
+    free(c.pool);
+    free(c.child);
+    free(c.pop);
+    free(c.next);
+    scratch_free(&c.scratch);
+    astar_free_workspace();
+    cleanup_shared_memory();
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) min_ns = atof(argv[1]) * 1e6;
+
+    set_default_config();
+    config.seed = 1;
+    config.population_size = 200;
+    config.max_path_length = 500;
+    config.num_processes = 1;
+    config.mutation_rate = 1.0;
+    config.fitness_cache_size = 0;
+    config.priority_default = 1;
+
+    cycles_open();
+    printf("Microbenchmarks: %.0f ms per op, fitness cache off, cycles from %s, kernel %s, astar_mode %s\n",
+           min_ns / 1e6, cycles_source(), config.fitness_kernel, config.astar_mode);
+
+    for (size_t i = 0; i < sizeof(grids) / sizeof(grids[0]); i++) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            bench_grid(&grids[i]);
+            fflush(stdout);
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "%s grid failed\n", grids[i].name);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -1,7 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <sched.h>
 #include <time.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/ipc.h>
@@ -11,6 +16,11 @@
 #include "pool.h"
 #include "config.h"
 #include "genetic.h"
+#include "grid.h"
+#include "genome.h"
+#include "rng.h"
+#include "island.h"
+#include "telemetry.h"
 
 // union semun for SysV semctl
 union semun {
@@ -36,7 +46,97 @@ void unlock_sem(void) {
     if (semop(semid, &sem_unlock_op, 1) == -1) { perror("semop unlock"); _exit(1); }
 }
 
-void write_data_file(int snapshot_num) {
+static void write_path(FILE *f, const Path *p) {
+    fprintf(f, "PATH: %d\n", p->length);
+    Coord c = p->start;
+    for (int i = 0; i < p->length; i++) {
+        if (i > 0) c = genome_step(c, genome_move(p, i - 1));
+        fprintf(f, "%d %d %d\n", c.x, c.y, c.z);
+    }
+}
+
+static long futex(atomic_uint *addr, int op, unsigned val) {
+    return syscall(SYS_futex, (unsigned *)addr, op, val, NULL, NULL, 0);
+}
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+long pool_peak_rss_kb(void) {
+    // VmHWM, not getrusage: ru_maxrss survives exec and would include the
+    // launcher's footprint
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) return 0;
+    char line[256];
+    long kb = 0;
+    while (fgets(line, sizeof(line), f))
+        if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) break;
+    fclose(f);
+    return kb;
+}
+
+void pool_notify(void) {
+    shared->event_ms = now_ms();
+    atomic_fetch_add(&shared->event_seq, 1);
+    futex(&shared->event_seq, FUTEX_WAKE, INT_MAX);
+}
+
+unsigned pool_event_seq(void) {
+    return atomic_load(&shared->event_seq);
+}
+
+int pool_wait_event(unsigned seen, double max_ms) {
+    if (atomic_load(&shared->event_seq) != seen) return 1;
+    if (max_ms <= 0) return 0;
+    struct timespec ts;
+    ts.tv_sec  = (time_t)(max_ms / 1e3);
+    ts.tv_nsec = (long)((max_ms - (double)ts.tv_sec * 1e3) * 1e6);
+    syscall(SYS_futex, (unsigned *)&shared->event_seq, FUTEX_WAIT, seen, &ts, NULL, 0);
+    return atomic_load(&shared->event_seq) != seen;
+}
+
+void pool_request_stop(void) {
+    atomic_store(&shared->stop_flag, 1);
+    atomic_fetch_add(&shared->barrier_seq, 1);
+    futex(&shared->barrier_seq, FUTEX_WAKE, INT_MAX);
+}
+
+// Process-shared barrier over barrier_seq. The last arrival resets the count,
+// advances the generation and bumps the sequence; the others spin briefly
+// on it, then sleep in FUTEX_WAIT. The count is reset before the bump, so
+// nobody can arrive at the next barrier while it still holds this one's.
+// A stop request bumps the sequence too, releasing everyone. A worker that
+// reaches the barrier after that bump would wait on the new sequence for
+// peers that have already left, so stop_flag (set before the bump) is
+// checked once seq is loaded and on every pass of the wait.
+static void barrier_wait(int n) {
+    unsigned seq = atomic_load(&shared->barrier_seq);
+    if (atomic_load(&shared->stop_flag)) return;
+    if (atomic_fetch_add(&shared->workers_done, 1) + 1 == n) {
+        atomic_store(&shared->workers_done, 0);
+        atomic_fetch_add(&shared->generation, 1);
+        atomic_fetch_add(&shared->barrier_seq, 1);
+        futex(&shared->barrier_seq, FUTEX_WAKE, INT_MAX);
+        pool_notify();
+        return;
+    }
+    for (int spin = 0; atomic_load(&shared->barrier_seq) == seq; spin++) {
+        if (atomic_load(&shared->stop_flag)) return;
+        if (spin < 2000) { cpu_relax(); continue; }
+        futex(&shared->barrier_seq, FUTEX_WAIT, seq);  // returns at once if seq moved
+    }
+}
+
+void write_data_file(int snapshot_num, int gen, const Path *best) {
     char filename[64];
     sprintf(filename, "robot_data_%d.txt", snapshot_num);
 
@@ -44,8 +144,8 @@ void write_data_file(int snapshot_num) {
     if (!f) return;
 
     fprintf(f, "GRID: %d %d %d\n", config.grid_x, config.grid_y, config.grid_z);
-    fprintf(f, "GEN: %d\n", shared->generation);
-    fprintf(f, "FITNESS: %.2f\n", shared->best_fitness);
+    fprintf(f, "GEN: %d\n", gen);
+    fprintf(f, "FITNESS: %.2f\n", best->fitness);
 
     fprintf(f, "SURVIVORS: %d\n", config.num_survivors);
     for (int i = 0; i < config.num_survivors; i++)
@@ -57,10 +157,7 @@ void write_data_file(int snapshot_num) {
     for (int i = 0; i < config.num_obstacles; i++)
         fprintf(f, "%d %d %d\n", shared->obstacles[i].x, shared->obstacles[i].y, shared->obstacles[i].z);
 
-    fprintf(f, "PATH: %d\n", shared->best_path.length);
-    for (int i = 0; i < shared->best_path.length; i++)
-        fprintf(f, "%d %d %d\n",
-                shared->best_path.genes[i].x, shared->best_path.genes[i].y, shared->best_path.genes[i].z);
+    write_path(f, best);
 
     fclose(f);
 }
@@ -83,9 +180,7 @@ void write_astar_file(const char *filename, const Path *p) {
     for (int i = 0; i < config.num_obstacles; i++)
         fprintf(f, "%d %d %d\n", shared->obstacles[i].x, shared->obstacles[i].y, shared->obstacles[i].z);
 
-    fprintf(f, "PATH: %d\n", p->length);
-    for (int i = 0; i < p->length; i++)
-        fprintf(f, "%d %d %d\n", p->genes[i].x, p->genes[i].y, p->genes[i].z);
+    write_path(f, p);
 
     fclose(f);
 }
@@ -94,10 +189,14 @@ void init_shared_memory(void) {
     size_t shm_size =
         sizeof(SharedData) +
         (size_t)config.population_size * sizeof(Path) +
-        (size_t)config.grid_x * config.grid_y * config.grid_z * sizeof(int) +
+        (size_t)(config.population_size + 1) * genome_bytes(config.max_path_length) +
+        (size_t)config.num_processes * sizeof(double) +
+        island_shared_bytes() +
+        telemetry_shared_bytes() +
         (size_t)config.num_survivors * sizeof(Coord) +
         (size_t)config.num_survivors * sizeof(int) +
-        (size_t)config.num_obstacles * sizeof(Coord);
+        (size_t)config.num_obstacles * sizeof(Coord) +
+        grid_shared_bytes();
 
     shmid = shmget(IPC_PRIVATE, shm_size, IPC_CREAT | 0666);
     if (shmid < 0) { perror("shmget"); exit(1); }
@@ -110,8 +209,15 @@ void init_shared_memory(void) {
     shared->population = (Path *)ptr;
     ptr += (size_t)config.population_size * sizeof(Path);
 
-    shared->grid = (int *)ptr;
-    ptr += (size_t)config.grid_x * config.grid_y * config.grid_z * sizeof(int);
+    // genome storage: the population's slots, then best_path's
+    ptr = genome_bind(shared->population, config.population_size, config.max_path_length, ptr);
+    ptr = genome_bind(&shared->best_path, 1, config.max_path_length, ptr);
+
+    shared->wait_ms = (double *)ptr;
+    ptr += (size_t)config.num_processes * sizeof(double);
+
+    ptr = island_attach(ptr);
+    ptr = telemetry_attach(ptr);
 
     shared->survivors = (Coord *)ptr;
     ptr += (size_t)config.num_survivors * sizeof(Coord);
@@ -120,6 +226,9 @@ void init_shared_memory(void) {
     ptr += (size_t)config.num_survivors * sizeof(int);
 
     shared->obstacles = (Coord *)ptr;
+    ptr += (size_t)config.num_obstacles * sizeof(Coord);
+
+    grid_attach(ptr);
 
     semid = semget(IPC_PRIVATE, 1, IPC_CREAT | 0666);
     if (semid < 0) { perror("semget"); exit(1); }
@@ -128,10 +237,27 @@ void init_shared_memory(void) {
     arg.val = 1;
     if (semctl(semid, 0, SETVAL, arg) < 0) { perror("semctl"); exit(1); }
 
-    shared->generation   = 0;
-    shared->workers_done = 0;
-    shared->stop_flag    = 0;
+    atomic_init(&shared->generation, 0);
+    atomic_init(&shared->workers_done, 0);
+    atomic_init(&shared->stop_flag, 0);
+    atomic_init(&shared->barrier_seq, 0);
+    atomic_init(&shared->event_seq, 0);
+    shared->event_ms = 0;
+    atomic_init(&shared->evaluations, 0);
+    atomic_init(&shared->best_seq, 0);
+    shared->ga_start_ms = 0;
+    shared->target_ms   = -1;
+    shared->target_gen  = 0;
+    for (int i = 0; i < config.num_processes; i++) shared->wait_ms[i] = 0;
     shared->best_fitness = -1e18;
+    shared->best_worker  = -1;
+
+    shared->evals         = 0;
+    shared->evals_skipped = 0;
+    shared->cache_hits    = 0;
+    shared->cache_misses  = 0;
+    shared->steady_inserted = 0;
+    shared->worker_rss_kb   = 0;
 }
 
 void cleanup_shared_memory(void) {
@@ -140,85 +266,198 @@ void cleanup_shared_memory(void) {
     if (semid != -1) semctl(semid, 0, IPC_RMID);
 }
 
+// best_fitness/best_worker/best_path are guarded by the best_seq seqlock:
+// odd while a writer is inside. Writers take it with a CAS from an even
+// value; readers copy without locking and retry if the sequence moved.
+
+static int better_than_best(const Path *p, int worker_id) {
+    return p->fitness > shared->best_fitness ||
+           (p->fitness == shared->best_fitness && worker_id < shared->best_worker);
+}
+
+// Equal fitness goes to the lower worker id so the published path does not
+// depend on which worker got there first.
+void pool_publish_best(const Path *p, int worker_id) {
+    // cheap optimistic check first; most publishes are not improvements
+    unsigned s = atomic_load_explicit(&shared->best_seq, memory_order_acquire);
+    if (!(s & 1)) {
+        int better = better_than_best(p, worker_id);
+        atomic_thread_fence(memory_order_acquire);
+        if (!better && atomic_load_explicit(&shared->best_seq, memory_order_relaxed) == s) return;
+    }
+
+    for (int spin = 0;; spin++) {
+        s = atomic_load_explicit(&shared->best_seq, memory_order_relaxed);
+        if (!(s & 1) &&
+            atomic_compare_exchange_weak_explicit(&shared->best_seq, &s, s + 1,
+                                                  memory_order_acquire, memory_order_relaxed))
+            break;
+        if (spin < 100) cpu_relax(); else sched_yield();
+    }
+    atomic_thread_fence(memory_order_release);
+    if (better_than_best(p, worker_id)) {
+        shared->best_fitness = p->fitness;
+        shared->best_worker = worker_id;
+        genome_copy(&shared->best_path, p);
+        if (config.target_set && shared->target_ms < 0 && p->fitness >= config.target_fitness) {
+            shared->target_ms  = now_ms() - shared->ga_start_ms;
+            shared->target_gen = atomic_load(&shared->generation);
+        }
+    }
+    atomic_store_explicit(&shared->best_seq, s + 2, memory_order_release);
+}
+
+// Consistent copy of the best path, never blocking a writer. genome_copy
+// clamps to out's capacity, so a torn read is safe to take and discard.
+void pool_read_best(Path *out) {
+    for (int spin = 0;; spin++) {
+        unsigned s = atomic_load_explicit(&shared->best_seq, memory_order_acquire);
+        if (!(s & 1)) {
+            genome_copy(out, &shared->best_path);
+            out->fitness = shared->best_fitness;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&shared->best_seq, memory_order_relaxed) == s) return;
+        }
+        if (spin < 100) cpu_relax(); else sched_yield();
+    }
+}
+
+double pool_best_fitness(void) {
+    for (;;) {
+        unsigned s = atomic_load_explicit(&shared->best_seq, memory_order_acquire);
+        double f = shared->best_fitness;
+        atomic_thread_fence(memory_order_acquire);
+        if (!(s & 1) && atomic_load_explicit(&shared->best_seq, memory_order_relaxed) == s) return f;
+        cpu_relax();
+    }
+}
+
+// ga_mode=steady: count n more evaluations and move shared->generation up
+// to match; workers race, so it only ever grows.
+static void steady_progress(long n) {
+    long e = atomic_fetch_add(&shared->evaluations, n) + n;
+    int g = (int)(e / ((long)GENS_PER_BARRIER * config.population_size));
+    int cur = atomic_load(&shared->generation);
+    while (cur < g) {
+        if (atomic_compare_exchange_weak(&shared->generation, &cur, g)) {
+            pool_notify();
+            break;
+        }
+    }
+}
+
+// ga_mode=steady: no barrier. Children replace members one batch at a
+// time; a local generation is subN evaluations, after which the worker
+// publishes, reports progress and migrates without waiting for anyone.
+static long steady_loop(int worker_id, Path *local, int subN, Path *local_best,
+                        FitnessScratch *scratch, Rng *rng) {
+    Path *kids = genome_alloc(STEADY_BATCH, config.max_path_length);
+    long inserted = 0;
+    int local_gen = 0;
+
+    while (!atomic_load(&shared->stop_flag) &&
+           atomic_load(&shared->generation) < config.num_generations) {
+        for (int bred = 0; bred < subN; bred += STEADY_BATCH) {
+            int n = (subN - bred < STEADY_BATCH) ? subN - bred : STEADY_BATCH;
+            inserted += steady_step(local, subN, kids, n, scratch, rng);
+            for (int i = 0; i < n; i++)
+                if (kids[i].fitness > local_best->fitness) genome_copy(local_best, &kids[i]);
+        }
+        local_gen++;
+        if (telemetry_on()) telemetry_emit(worker_id, local_gen, local, subN, scratch, 0);
+
+        pool_publish_best(local_best, worker_id);
+        steady_progress(subN);
+
+        // rings take whatever has arrived; neighbours run at their own pace
+        if (island_due(local_gen)) {
+            island_emigrate(worker_id, local, subN);
+            island_immigrate(worker_id, local, subN, rng);
+        }
+    }
+    free(kids);
+    return inserted;
+}
+
 static void worker_process(int worker_id) {
-    srand((unsigned int)(time(NULL) ^ (worker_id * 7919) ^ (getpid() << 16)));
+    Rng rng;
+    rng_seed(&rng, config.seed, (unsigned long long)worker_id + 1);
 
     int subN = config.population_size / config.num_processes;
     if (subN < 10) subN = 10;
 
-    Path *local = (Path *)malloc((size_t)subN * sizeof(Path));
-    if (!local) _exit(1);
+    // current and next generation, swapped by evolve_population_local
+    Path *local = genome_alloc(subN, config.max_path_length);
+    Path *spare = genome_alloc(subN, config.max_path_length);
+    Path *local_best = genome_alloc(1, config.max_path_length);
+
+    FitnessScratch scratch;
+    scratch_init(&scratch);
 
     for (int i = 0; i < subN; i++) {
-        generate_random_path(&local[i]);
-        calculate_fitness(&local[i]);
+        generate_random_path(&local[i], &rng);
+        calculate_fitness(&local[i], &scratch);
     }
 
-    Path local_best = local[0];
+    genome_copy(local_best, &local[0]);
+    for (int i = 1; i < subN; i++)
+        if (local[i].fitness > local_best->fitness) genome_copy(local_best, &local[i]);
     int local_gen = 0;
+    double wait_ms = 0;
+    long inserted = 0;
 
-    while (1) {
-        lock_sem();
-        int stop = shared->stop_flag;
-        int g = shared->generation;
-        unlock_sem();
+    int steady = (strcmp(config.ga_mode, "steady") == 0);
+    if (steady) inserted = steady_loop(worker_id, local, subN, local_best, &scratch, &rng);
 
-        if (stop || g >= config.num_generations) break;
+    while (!steady) {
+        if (atomic_load(&shared->stop_flag) ||
+            atomic_load(&shared->generation) >= config.num_generations) break;
 
         for (int i = 0; i < subN; i++)
-            if (local[i].fitness > local_best.fitness) local_best = local[i];
+            if (local[i].fitness > local_best->fitness) genome_copy(local_best, &local[i]);
 
-        evolve_population_local(local, subN);
+        evolve_population_local(&local, &spare, subN, &scratch, &rng);
         local_gen++;
+        if (telemetry_on()) telemetry_emit(worker_id, local_gen, local, subN, &scratch, wait_ms);
 
-        if (local_gen % 5 == 0) {
-            lock_sem();
-
-            if (local_best.fitness > shared->best_fitness) {
-                shared->best_fitness = local_best.fitness;
-                shared->best_path = local_best;
-            }
-
-            shared->workers_done++;
-            if (shared->workers_done == config.num_processes) {
-                shared->workers_done = 0;
-                shared->generation++;
-            }
-
-            unlock_sem();
-
-            // barrier wait with timeout safety
-            int spins = 0;
-            while (1) {
-                lock_sem();
-                int done = shared->workers_done;
-                int stop2 = shared->stop_flag;
-                unlock_sem();
-                if (stop2 || done == 0) break;
-                usleep(200);
-                spins++;
-                if (spins > 20000) { // ~4s
-                    lock_sem();
-                    shared->stop_flag = 1;
-                    unlock_sem();
-                    break;
-                }
-            }
+        if (local_gen % GENS_PER_BARRIER == 0) {
+            pool_publish_best(local_best, worker_id);
+            int migrate = island_due(local_gen);
+            if (migrate) island_emigrate(worker_id, local, subN);
+
+            double t0 = now_ms();
+            barrier_wait(config.num_processes);
+            wait_ms += now_ms() - t0;
+
+            // every neighbour emigrated before the barrier let us through
+            if (migrate && !atomic_load(&shared->stop_flag))
+                island_immigrate(worker_id, local, subN, &rng);
         }
     }
 
+    pool_publish_best(local_best, worker_id);
+
     lock_sem();
-    if (local_best.fitness > shared->best_fitness) {
-        shared->best_fitness = local_best.fitness;
-        shared->best_path = local_best;
-    }
+    shared->wait_ms[worker_id] = wait_ms;
+    shared->evals         += scratch.evaluated;
+    shared->evals_skipped += scratch.skipped;
+    shared->cache_hits    += scratch.cache.hits;
+    shared->cache_misses  += scratch.cache.misses;
+    shared->steady_inserted += inserted;
+    long rss = pool_peak_rss_kb();
+    if (rss > shared->worker_rss_kb) shared->worker_rss_kb = rss;
     unlock_sem();
 
+    scratch_free(&scratch);
     free(local);
+    free(spare);
+    free(local_best);
+    pool_notify();  // the supervisor may be waiting for the last worker
     _exit(0);
 }
 
 void create_process_pool(pid_t *pids) {
+    shared->ga_start_ms = now_ms();
     for (int i = 0; i < config.num_processes; i++) {
         pid_t pid = fork();
         if (pid == 0) worker_process(i);
@@ -17,7 +17,33 @@ void wait_for_workers(pid_t *pids);
 void lock_sem(void);
 void unlock_sem(void);
 
-void write_data_file(int snapshot_num);
+// Sets stop_flag and wakes any worker blocked in the barrier.
+void pool_request_stop(void);
+
+// Supervisor wake-ups. Workers call pool_notify when shared->generation
+// moves or they exit. The supervisor reads pool_event_seq, checks the
+// shared state, then sleeps in pool_wait_event until the sequence moves
+// past `seen` or max_ms passes (FUTEX_WAIT on CLOCK_MONOTONIC); returns 1 if
+// it moved. Reading before checking means no notification is lost.
+void     pool_notify(void);
+unsigned pool_event_seq(void);
+int      pool_wait_event(unsigned seen, double max_ms);
+
+// Local generations between two barriers; shared->generation counts barriers.
+#define GENS_PER_BARRIER 5
+
+// Publish p as the best if it beats the current one (seqlock writer).
+void   pool_publish_best(const Path *p, int worker_id);
+
+// Lock-free readers of the published best (seqlock, never block workers).
+void   pool_read_best(Path *out);   // out->fitness = best_fitness
+double pool_best_fitness(void);
+
+// Peak resident set of the calling process in KB (0 if unknown).
+long pool_peak_rss_kb(void);
+
+// Snapshot of a copy taken with pool_read_best; see snapshot.h.
+void write_data_file(int snapshot_num, int gen, const Path *best);
 void write_astar_file(const char *filename, const Path *p);
 
 #endif
@@ -0,0 +1,51 @@
+#ifndef RNG_H
+#define RNG_H
+
+// xoshiro256** streams. Every consumer owns one: the main process uses
+// stream 0, worker i stream i+1, all derived from config.seed, so a seed and
+// a worker count replay the same run.
+typedef struct {
+    unsigned long long s[4];
+} Rng;
+
+static inline unsigned long long rng_rotl(unsigned long long v,int r){
+    return (v<<r) | (v>>(64-r));
+}
+
+static inline unsigned long long rng_splitmix(unsigned long long *x){
+    unsigned long long z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z>>30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z>>27)) * 0x94D049BB133111EBULL;
+    return z ^ (z>>31);
+}
+
+// State from splitmix64 over (seed, stream); never all zero.
+static inline void rng_seed(Rng *r,unsigned long long seed,unsigned long long stream){
+    unsigned long long x = seed ^ rng_splitmix(&stream);
+    for(int i=0;i<4;i++) r->s[i] = rng_splitmix(&x);
+}
+
+static inline unsigned long long rng_next(Rng *r){
+    unsigned long long *s = r->s;
+    unsigned long long out = rng_rotl(s[1]*5, 7) * 9;
+    unsigned long long t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return out;
+}
+
+// Uniform in [0, n) by multiply-shift; n must be positive.
+static inline int rng_below(Rng *r,int n){
+    return (int)(((rng_next(r)>>32) * (unsigned long long)(unsigned)n) >> 32);
+}
+
+// Uniform in [0, 1).
+static inline double rng_unit(Rng *r){
+    return (double)(rng_next(r)>>11) * (1.0/9007199254740992.0);
+}
+
+#endif
@@ -0,0 +1,20 @@
+#!/bin/bash
+# Generations/sec of both backends for 1..N workers.
+# usage: ./scaling.sh [config] [max_workers]   (defaults: config.txt, nproc)
+cfg=${1:-config.txt}
+max=${2:-$(nproc)}
+tmp=$(mktemp)
+trap 'rm -f "$tmp"' EXIT
+
+printf "%-8s %-10s %14s %14s\n" workers backend "gens/sec" "children/sec"
+for n in $(seq 1 "$max"); do
+    for b in processes threads; do
+        # fixed seed and no early stop, so every run does the same work
+        grep -vE '^(num_processes|backend|seed|stagnation_limit|time_limit_seconds)=' "$cfg" > "$tmp"
+        printf "num_processes=%d\nbackend=%s\nseed=1\nstagnation_limit=0\ntime_limit_seconds=0\n" "$n" "$b" >> "$tmp"
+        line=$(echo 3 | ./rescue_robot "$tmp" | grep '^Throughput')
+        gps=$(echo "$line" | sed -E 's/.*: ([0-9.]+) generations.*/\1/')
+        cps=$(echo "$line" | sed -E 's/.*\| ([0-9.]+) children.*/\1/')
+        printf "%-8d %-10s %14s %14s\n" "$n" "$b" "$gps" "$cps"
+    done
+done
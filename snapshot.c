@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "snapshot.h"
+#include "snapshot_log.h"
+#include "pool.h"
+#include "config.h"
+#include "genome.h"
+
+typedef struct {
+    Path *path;
+    int   num;
+    int   gen;
+} Snap;
+
+// Two slots: the thread writes one while main fills the other.
+static Snap            slots[2];
+static Path           *slot_paths;
+static int             pending = -1;   // slot waiting to be written
+static int             writing = -1;   // slot the thread is writing
+static int             quit;
+static pthread_mutex_t mu = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cv = PTHREAD_COND_INITIALIZER;
+static pthread_t       writer;
+static FILE           *log_file;       // snapshot_format=binary
+
+// The environment, once, ahead of every record.
+static void log_write_header(FILE *f) {
+    SnapLogHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SNAPLOG_MAGIC, 8);
+    h.version        = SNAPLOG_VERSION;
+    h.header_bytes   = (uint32_t)snaplog_header_bytes(config.num_survivors, config.num_obstacles);
+    h.grid_x         = config.grid_x;
+    h.grid_y         = config.grid_y;
+    h.grid_z         = config.grid_z;
+    h.num_survivors  = config.num_survivors;
+    h.num_obstacles  = config.num_obstacles;
+    h.moves_per_word = SNAPLOG_MOVES_PER_WORD;
+    fwrite(&h, sizeof(h), 1, f);
+
+    for (int i = 0; i < config.num_survivors; i++) {
+        int32_t s[4] = { shared->survivors[i].x, shared->survivors[i].y, shared->survivors[i].z,
+                         shared->survivor_priority[i] };
+        fwrite(s, sizeof(s), 1, f);
+    }
+    for (int i = 0; i < config.num_obstacles; i++) {
+        int32_t o[3] = { shared->obstacles[i].x, shared->obstacles[i].y, shared->obstacles[i].z };
+        fwrite(o, sizeof(o), 1, f);
+    }
+    static const char zero[8];
+    size_t used = sizeof(h) + (size_t)config.num_survivors * 16 + (size_t)config.num_obstacles * 12;
+    fwrite(zero, 1, h.header_bytes - used, f);
+    fflush(f);
+}
+
+// One length-prefixed record; flushed whole so a reader sees it complete
+// or not at all (a short tail is skipped by the reader).
+static void log_append(FILE *f, int num, int gen, const Path *p) {
+    SnapLogRecord r;
+    memset(&r, 0, sizeof(r));
+    r.words        = snaplog_words(p->length);
+    r.record_bytes = (uint32_t)(sizeof(r) + (size_t)r.words * sizeof(uint64_t));
+    r.snapshot_num = num;
+    r.gen          = gen;
+    r.length       = p->length;
+    r.fitness      = p->fitness;
+    r.start[0] = p->start.x; r.start[1] = p->start.y; r.start[2] = p->start.z;
+    fwrite(&r, sizeof(r), 1, f);
+
+    if (r.words > 0) {
+        fwrite(p->moves, sizeof(uint64_t), (size_t)r.words - 1, f);
+        // clear the bits past the last move so equal paths give equal bytes
+        int used = (p->length - 1) - (r.words - 1) * SNAPLOG_MOVES_PER_WORD;
+        uint64_t last = p->moves[r.words - 1];
+        if (used < SNAPLOG_MOVES_PER_WORD) last &= (1ULL << (3 * used)) - 1;
+        fwrite(&last, sizeof(last), 1, f);
+    }
+    fflush(f);
+}
+
+static void *writer_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&mu);
+    while (1) {
+        while (pending < 0 && !quit) pthread_cond_wait(&cv, &mu);
+        if (pending < 0) break;
+        writing = pending;
+        pending = -1;
+        pthread_mutex_unlock(&mu);
+
+        Snap *s = &slots[writing];
+        if (log_file) log_append(log_file, s->num, s->gen, s->path);
+        else write_data_file(s->num, s->gen, s->path);
+
+        pthread_mutex_lock(&mu);
+        writing = -1;
+    }
+    pthread_mutex_unlock(&mu);
+    return NULL;
+}
+
+void snapshot_start(void) {
+    slot_paths = genome_alloc(2, config.max_path_length);
+    slots[0].path = &slot_paths[0];
+    slots[1].path = &slot_paths[1];
+    pending = writing = -1;
+    quit = 0;
+    log_file = NULL;
+    if (strcmp(config.snapshot_format, "binary") == 0) {
+        log_file = fopen(SNAPLOG_FILE, "wb");
+        if (!log_file) perror(SNAPLOG_FILE);  // carry on with text snapshots
+        else log_write_header(log_file);
+    }
+    if (pthread_create(&writer, NULL, writer_main, NULL) != 0) {
+        fprintf(stderr, "snapshot thread failed\n");
+        exit(1);
+    }
+}
+
+void snapshot_request(int snapshot_num, int gen) {
+    pthread_mutex_lock(&mu);
+    int i = (pending >= 0) ? pending : (writing == 0 ? 1 : 0);
+    pool_read_best(slots[i].path);
+    slots[i].num = snapshot_num;
+    slots[i].gen = gen;
+    pending = i;
+    pthread_cond_signal(&cv);
+    pthread_mutex_unlock(&mu);
+}
+
+void snapshot_stop(void) {
+    pthread_mutex_lock(&mu);
+    quit = 1;
+    pthread_cond_signal(&cv);
+    pthread_mutex_unlock(&mu);
+    pthread_join(writer, NULL);
+    if (log_file) fclose(log_file);
+    log_file = NULL;
+    free(slot_paths);
+    slot_paths = NULL;
+}
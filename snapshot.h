@@ -0,0 +1,20 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+// Snapshot writer thread in the main process. snapshot_request takes a
+// seqlock copy of the best path and returns; the file is written by the
+// thread, so neither main nor the workers wait on the filesystem. If a
+// request arrives while the previous one is still pending, the newer
+// copy replaces it and the older file is skipped.
+//
+// snapshot_format=text (the default) writes robot_data_N.txt per snapshot
+// (write_data_file); binary appends a record to SNAPLOG_FILE instead, see
+// snapshot_log.h.
+#define SNAPLOG_FILE "robot_data.snap"
+
+void snapshot_start(void);
+void snapshot_request(int snapshot_num, int gen);
+// Writes whatever is pending, then joins the thread.
+void snapshot_stop(void);
+
+#endif
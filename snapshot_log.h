@@ -0,0 +1,138 @@
+#ifndef SNAPSHOT_LOG_H
+#define SNAPSHOT_LOG_H
+
+// Binary snapshot log (snapshot_format=binary): one file (SNAPLOG_FILE),
+// holding the static environment once and then one record per snapshot,
+// appended as the run goes. All fields are little-endian and every record
+// starts 8-byte aligned, so a reader can mmap the file and point straight
+// into it.
+//
+//   SnapLogHeader
+//   int32 survivors[num_survivors][4]   x, y, z, priority
+//   int32 obstacles[num_obstacles][3]   x, y, z
+//   (zero padding to header_bytes)
+//   SnapLogRecord + uint64 moves[words]  repeated
+//
+// Moves are the genome's: 3 bits each, SNAPLOG_MOVES_PER_WORD to a word
+// from bit 0 up, codes 0..5 = +x -x +y -y +z -z; unused bits are zero.
+// A record whose record_bytes runs past the end of the file is a write
+// still in progress and is ignored.
+//
+// The reader below is header-only and copies nothing:
+//   SnapLog log;
+//   if (snaplog_open(&log, "robot_data.snap") == 0) {
+//       for (const SnapLogRecord *r = snaplog_first(&log); r; r = snaplog_next(&log, r))
+//           ... r->fitness, snaplog_move(r, i) ...
+//       snaplog_close(&log);
+//   }
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SNAPLOG_MAGIC          "RBSNAP01"
+#define SNAPLOG_VERSION        1
+#define SNAPLOG_MOVES_PER_WORD 21
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_bytes;   // offset of the first record
+    int32_t  grid_x, grid_y, grid_z;
+    int32_t  num_survivors, num_obstacles;
+    int32_t  moves_per_word;
+} SnapLogHeader;
+
+typedef struct {
+    uint32_t record_bytes;   // this record and its moves
+    int32_t  snapshot_num;
+    int32_t  gen;
+    int32_t  length;         // cells, start included
+    double   fitness;
+    int32_t  start[3];
+    int32_t  words;          // uint64 move words that follow
+} SnapLogRecord;
+
+_Static_assert(sizeof(SnapLogHeader) == 40, "SnapLogHeader layout");
+_Static_assert(sizeof(SnapLogRecord) == 40, "SnapLogRecord layout");
+
+static inline size_t snaplog_align(size_t n) { return (n + 7) & ~(size_t)7; }
+
+static inline size_t snaplog_header_bytes(int num_survivors, int num_obstacles) {
+    return snaplog_align(sizeof(SnapLogHeader) + (size_t)num_survivors * 16 + (size_t)num_obstacles * 12);
+}
+
+static inline int snaplog_words(int length) {
+    return (length - 1 + SNAPLOG_MOVES_PER_WORD - 1) / SNAPLOG_MOVES_PER_WORD;
+}
+
+typedef struct {
+    const unsigned char *base;
+    size_t               size;
+    const SnapLogHeader *hdr;
+} SnapLog;
+
+// 0 on success, -1 if the file cannot be mapped or is not a snapshot log.
+static inline int snaplog_open(SnapLog *log, const char *filename) {
+    memset(log, 0, sizeof(*log));
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(SnapLogHeader)) { close(fd); return -1; }
+    void *m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) return -1;
+
+    log->base = (const unsigned char *)m;
+    log->size = (size_t)st.st_size;
+    log->hdr  = (const SnapLogHeader *)m;
+    if (memcmp(log->hdr->magic, SNAPLOG_MAGIC, 8) != 0 || log->hdr->version != SNAPLOG_VERSION ||
+        log->hdr->header_bytes > log->size) {
+        munmap(m, log->size);
+        memset(log, 0, sizeof(*log));
+        return -1;
+    }
+    return 0;
+}
+
+static inline void snaplog_close(SnapLog *log) {
+    if (log->base) munmap((void *)log->base, log->size);
+    memset(log, 0, sizeof(*log));
+}
+
+static inline const int32_t *snaplog_survivors(const SnapLog *log) {
+    return (const int32_t *)(log->base + sizeof(SnapLogHeader));
+}
+
+static inline const int32_t *snaplog_obstacles(const SnapLog *log) {
+    return snaplog_survivors(log) + 4 * (size_t)log->hdr->num_survivors;
+}
+
+static inline const SnapLogRecord *snaplog_at(const SnapLog *log, size_t off) {
+    if (off + sizeof(SnapLogRecord) > log->size) return NULL;
+    const SnapLogRecord *r = (const SnapLogRecord *)(log->base + off);
+    if (r->record_bytes < sizeof(SnapLogRecord) || off + r->record_bytes > log->size) return NULL;
+    return r;
+}
+
+static inline const SnapLogRecord *snaplog_first(const SnapLog *log) {
+    return snaplog_at(log, log->hdr->header_bytes);
+}
+
+static inline const SnapLogRecord *snaplog_next(const SnapLog *log, const SnapLogRecord *r) {
+    return snaplog_at(log, (size_t)((const unsigned char *)r - log->base) + r->record_bytes);
+}
+
+static inline const uint64_t *snaplog_moves(const SnapLogRecord *r) {
+    return (const uint64_t *)(r + 1);
+}
+
+// Move i (0 .. length-2) of a record.
+static inline int snaplog_move(const SnapLogRecord *r, int i) {
+    return (int)(snaplog_moves(r)[i / SNAPLOG_MOVES_PER_WORD] >> (3 * (i % SNAPLOG_MOVES_PER_WORD))) & 7;
+}
+
+#endif
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#include "telemetry.h"
+#include "pool.h"
+#include "config.h"
+#include "fitness_cache.h"
+
+#define TEL_RING 1024   // records per worker, power of two
+
+typedef struct {
+    double t_ms;          // since the workers started
+    int    worker;
+    int    local_gen;
+    int    generation;    // shared->generation when emitted
+    double best;
+    double mean;
+    double diversity;     // distinct genomes / N
+    long   evals;         // fitness evaluations so far
+    long   children;      // bred so far: evaluated + skipped + cache hits
+    long   cache_hits;
+    long   cache_misses;
+    double wait_ms;
+} TelRec;
+
+typedef struct {
+    atomic_uint head;
+    char        pad0[64 - sizeof(atomic_uint)];
+    atomic_uint tail;
+    char        pad1[64 - sizeof(atomic_uint)];
+    TelRec      slots[TEL_RING];
+} TelRing;
+
+// Set up by telemetry_attach before the fork, inherited by the workers.
+static TelRing     *rings;
+static atomic_long *dropped;
+static int          enabled;
+
+// Supervisor only.
+static FILE   *out;
+static long    written;
+static double *last_t;
+static long   *last_children;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+int telemetry_on(void) {
+    return enabled;
+}
+
+size_t telemetry_shared_bytes(void) {
+    if (!config.telemetry_file[0]) return 0;
+    return 64 + (size_t)config.num_processes * sizeof(TelRing) + sizeof(atomic_long);
+}
+
+char *telemetry_attach(char *ptr) {
+    enabled = (config.telemetry_file[0] != '\0');
+    if (!enabled) return ptr;
+    // rings hold doubles and sit after arbitrary regions
+    ptr = (char *)(((size_t)ptr + 63) & ~(size_t)63);
+    rings = (TelRing *)ptr;
+    ptr += (size_t)config.num_processes * sizeof(TelRing);
+    for (int i = 0; i < config.num_processes; i++) {
+        atomic_init(&rings[i].head, 0);
+        atomic_init(&rings[i].tail, 0);
+    }
+    dropped = (atomic_long *)ptr;
+    ptr += sizeof(atomic_long);
+    atomic_init(dropped, 0);
+    return ptr;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long *)a, y = *(const unsigned long long *)b;
+    return (x > y) - (x < y);
+}
+
+void telemetry_emit(int worker, int local_gen, const Path *pop, int N,
+                    const FitnessScratch *s, double wait_ms) {
+    TelRing *r = &rings[worker];
+    unsigned h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned t = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (h - t >= TEL_RING) { atomic_fetch_add(dropped, 1); return; }
+
+    TelRec *e = &r->slots[h & (TEL_RING - 1)];
+    e->t_ms       = now_ms() - shared->ga_start_ms;
+    e->worker     = worker;
+    e->local_gen  = local_gen;
+    e->generation = atomic_load_explicit(&shared->generation, memory_order_relaxed);
+
+    double best = pop[0].fitness, sum = 0;
+    unsigned long long keys[N];
+    for (int i = 0; i < N; i++) {
+        if (pop[i].fitness > best) best = pop[i].fitness;
+        sum += pop[i].fitness;
+        keys[i] = genome_hash(&pop[i]);
+    }
+    qsort(keys, (size_t)N, sizeof(keys[0]), cmp_u64);
+    int distinct = (N > 0);
+    for (int i = 1; i < N; i++) distinct += (keys[i] != keys[i - 1]);
+
+    e->best         = best;
+    e->mean         = sum / N;
+    e->diversity    = (double)distinct / N;
+    e->evals        = s->evaluated;
+    e->children     = s->evaluated + s->skipped + s->cache.hits;
+    e->cache_hits   = s->cache.hits;
+    e->cache_misses = s->cache.misses;
+    e->wait_ms      = wait_ms;
+    atomic_store_explicit(&r->head, h + 1, memory_order_release);
+}
+
+void telemetry_open(void) {
+    if (!enabled) return;
+    out = fopen(config.telemetry_file, "w");
+    if (!out) perror(config.telemetry_file);  // records are still drained, just not kept
+    last_t = (double *)calloc((size_t)config.num_processes, sizeof(double));
+    last_children = (long *)calloc((size_t)config.num_processes, sizeof(long));
+    if (!last_t || !last_children) { fprintf(stderr, "alloc failed\n"); exit(1); }
+    written = 0;
+}
+
+void telemetry_drain(void) {
+    if (!enabled) return;
+    for (int w = 0; w < config.num_processes; w++) {
+        TelRing *r = &rings[w];
+        unsigned t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        unsigned h = atomic_load_explicit(&r->head, memory_order_acquire);
+        for (; t != h; t++) {
+            const TelRec *e = &r->slots[t & (TEL_RING - 1)];
+            double dt = e->t_ms - last_t[w];
+            double cps = dt > 0 ? (double)(e->children - last_children[w]) * 1e3 / dt : 0;
+            long lookups = e->cache_hits + e->cache_misses;
+            last_t[w] = e->t_ms;
+            last_children[w] = e->children;
+            if (!out) continue;
+            fprintf(out,
+                    "{\"t_ms\":%.3f,\"worker\":%d,\"gen\":%d,\"global_gen\":%d,"
+                    "\"best\":%.2f,\"mean\":%.2f,\"diversity\":%.4f,"
+                    "\"evals\":%ld,\"children\":%ld,\"children_per_sec\":%.0f,\"cache_hit_rate\":%.4f,"
+                    "\"barrier_wait_ms\":%.3f}\n",
+                    e->t_ms, e->worker, e->local_gen, e->generation,
+                    e->best, e->mean, e->diversity,
+                    e->evals, e->children, cps, lookups ? (double)e->cache_hits / lookups : 0.0,
+                    e->wait_ms);
+            written++;
+        }
+        atomic_store_explicit(&r->tail, t, memory_order_release);
+    }
+    if (out) fflush(out);
+}
+
+void telemetry_close(void) {
+    if (!enabled) return;
+    telemetry_drain();
+    if (out) fclose(out);
+    out = NULL;
+    free(last_t);
+    free(last_children);
+    last_t = NULL;
+    last_children = NULL;
+}
+
+void telemetry_get_counts(long *w, long *d) {
+    *w = written;
+    *d = dropped ? atomic_load(dropped) : 0;
+}
@@ -0,0 +1,34 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+
+#include "types.h"
+#include "genetic.h"
+
+// Per-generation telemetry (telemetry_file=..., JSON lines). Each worker
+// owns a single-producer/single-consumer ring of fixed-size records in
+// shared memory; the supervisor drains them as it wakes and writes one line
+// per record. A full ring drops the record and counts it, so a slow disk
+// never holds up a worker. With no telemetry_file nothing is mapped and
+// telemetry_on() is the only cost.
+
+size_t telemetry_shared_bytes(void);
+char  *telemetry_attach(char *ptr);
+
+int  telemetry_on(void);
+
+// Worker side: summarises pop (N paths) after local generation local_gen.
+// wait_ms is the worker's barrier wait so far.
+void telemetry_emit(int worker, int local_gen, const Path *pop, int N,
+                    const FitnessScratch *s, double wait_ms);
+
+// Supervisor side: opens the file, appends every queued record, closes it.
+void telemetry_open(void);
+void telemetry_drain(void);
+void telemetry_close(void);
+
+// Records written, and dropped because a worker's ring was full.
+void telemetry_get_counts(long *written, long *dropped);
+
+#endif
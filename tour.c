@@ -0,0 +1,402 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "tour.h"
+#include "pool.h"
+#include "config.h"
+#include "grid.h"
+#include "genome.h"
+
+#define UNREACHED   (INT_MAX/4)
+#define NO_PARENT   255
+#define LS_WINDOW   50   // 2-opt / Or-opt only look this far along the tour
+#define LS_PASSES   20
+
+static const Coord dirs[6]={{1,0,0},{-1,0,0},{0,1,0},{0,-1,0},{0,0,1},{0,0,-1}};
+
+static inline int idx3(int x,int y,int z){
+    return z*config.grid_x*config.grid_y + y*config.grid_x + x;
+}
+static inline int coord_index(Coord c){ return idx3(c.x,c.y,c.z); }
+
+static double now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e3 + (double)ts.tv_nsec/1e6;
+}
+
+static TourStats stats;
+
+// Shared by the BFS threads: survivor s fills row s of dist and, when
+// kept, parent field s (direction from each cell one step towards s).
+typedef struct {
+    int            S;
+    int            start_cell;
+    int           *dist;       // S x (S+1); column S is the start
+    unsigned char **fields;    // NULL when the fields do not fit
+    atomic_int     next;
+} BfsJob;
+
+// BFS from cell `root`; `d` and `queue` are N-sized. Fills `parent` if given.
+static void bfs(int root, int *d, int *queue, unsigned char *parent){
+    int N = config.grid_x*config.grid_y*config.grid_z;
+    for(int i=0;i<N;i++) d[i]=UNREACHED;
+    if(parent) memset(parent,NO_PARENT,(size_t)N);
+
+    int head=0, tail=0;
+    d[root]=0;
+    queue[tail++]=root;
+
+    int gxy = config.grid_x*config.grid_y;
+    while(head<tail){
+        int cur=queue[head++];
+        Coord c={cur%config.grid_x, (cur%gxy)/config.grid_x, cur/gxy};
+        for(int k=0;k<6;k++){
+            Coord nb={c.x+dirs[k].x, c.y+dirs[k].y, c.z+dirs[k].z};
+            if(!grid_free(nb)) continue;
+            int ni=coord_index(nb);
+            if(d[ni]!=UNREACHED) continue;
+            d[ni]=d[cur]+1;
+            if(parent) parent[ni]=(unsigned char)(k^1); // opposite of k points back at cur
+            queue[tail++]=ni;
+        }
+    }
+}
+
+static void *bfs_worker(void *arg){
+    BfsJob *job=(BfsJob*)arg;
+    int N = config.grid_x*config.grid_y*config.grid_z;
+    int *d=(int*)malloc((size_t)N*sizeof(int));
+    int *queue=(int*)malloc((size_t)N*sizeof(int));
+    if(!d||!queue){ fprintf(stderr,"alloc failed\n"); exit(1); }
+
+    while(1){
+        int s=atomic_fetch_add(&job->next,1);
+        if(s>=job->S) break;
+        bfs(coord_index(shared->survivors[s]), d, queue, job->fields ? job->fields[s] : NULL);
+        for(int j=0;j<job->S;j++) job->dist[s*(job->S+1)+j]=d[coord_index(shared->survivors[j])];
+        job->dist[s*(job->S+1)+job->S]=d[job->start_cell];
+    }
+
+    free(d); free(queue);
+    return NULL;
+}
+
+// ---- visit-order solver over reachable survivors ----
+// Points are 0 = start, 1..n = survivors. A leg into point k costs its BFS
+// distance times (1 + w * R/P), R being the priority still unvisited
+// (including k) and P the total, so high-priority survivors are pulled
+// forward as w grows.
+
+typedef struct {
+    int     n;
+    int    *D;        // (n+1) x (n+1)
+    double *prio;     // per point, prio[0] = 0
+    double  total;
+    double  w;
+} Problem;
+
+static inline int pd(const Problem *P, int a, int b){ return P->D[a*(P->n+1)+b]; }
+
+static inline double leg_cost(const Problem *P, int a, int b, double remaining){
+    double f = (P->total>0) ? P->w*remaining/P->total : 0.0;
+    return (double)pd(P,a,b) * (1.0 + f);
+}
+
+static double tour_cost(const Problem *P, const int *t){
+    double c=0, R=0;
+    for(int k=P->n;k>=1;k--){ R+=P->prio[t[k]]; c+=leg_cost(P,t[k-1],t[k],R); }
+    return c;
+}
+
+// Legs lo..hi of tour t, with `r_after` the priority at positions > hi.
+static double legs_cost(const Problem *P, const int *t, int lo, int hi, double r_after){
+    double c=0, R=r_after;
+    for(int k=hi;k>=lo;k--){ R+=P->prio[t[k]]; c+=leg_cost(P,t[k-1],t[k],R); }
+    return c;
+}
+
+static void held_karp(const Problem *P, int *t){
+    int n=P->n;
+    size_t states=(size_t)1<<n;
+    double *dp=(double*)malloc(states*(size_t)n*sizeof(double));
+    int    *from=(int*)malloc(states*(size_t)n*sizeof(int));
+    double *mask_prio=(double*)calloc(states,sizeof(double));
+    if(!dp||!from||!mask_prio){ fprintf(stderr,"alloc failed\n"); exit(1); }
+
+    for(size_t m=1;m<states;m++){
+        int low=__builtin_ctzll((unsigned long long)m);
+        mask_prio[m]=mask_prio[m&(m-1)]+P->prio[low+1];
+    }
+    for(size_t i=0;i<states*(size_t)n;i++) dp[i]=1e300;
+    for(int j=0;j<n;j++){
+        dp[((size_t)1<<j)*n+j]=leg_cost(P,0,j+1,P->total);
+        from[((size_t)1<<j)*n+j]=-1;
+    }
+
+    for(size_t m=1;m<states;m++){
+        double remaining=P->total-mask_prio[m];
+        for(int last=0;last<n;last++){
+            if(!(m&((size_t)1<<last))) continue;
+            double cur=dp[m*n+last];
+            if(cur>=1e300) continue;
+            for(int j=0;j<n;j++){
+                if(m&((size_t)1<<j)) continue;
+                size_t nm=m|((size_t)1<<j);
+                double c=cur+leg_cost(P,last+1,j+1,remaining);
+                if(c<dp[nm*n+j]){ dp[nm*n+j]=c; from[nm*n+j]=last; }
+            }
+        }
+    }
+
+    size_t full=states-1;
+    int last=0;
+    for(int j=1;j<n;j++) if(dp[full*n+j]<dp[full*n+last]) last=j;
+
+    t[0]=0;
+    size_t m=full;
+    for(int k=n;k>=1;k--){
+        t[k]=last+1;
+        int prev=from[m*n+last];
+        m&=~((size_t)1<<last);
+        last=prev;
+    }
+
+    free(dp); free(from); free(mask_prio);
+}
+
+// Nearest insertion on plain distance: repeatedly take the point closest to
+// the partial tour and insert it where it adds the least distance.
+static void nearest_insertion(const Problem *P, int *t){
+    int n=P->n;
+    int *near=(int*)malloc((size_t)(n+1)*sizeof(int));
+    unsigned char *in=(unsigned char*)calloc((size_t)n+1,1);
+    if(!near||!in){ fprintf(stderr,"alloc failed\n"); exit(1); }
+
+    int len=1;
+    t[0]=0; in[0]=1;
+    for(int j=1;j<=n;j++) near[j]=pd(P,0,j);
+
+    while(len<=n){
+        int pick=-1;
+        for(int j=1;j<=n;j++) if(!in[j] && (pick<0 || near[j]<near[pick])) pick=j;
+
+        // open tour: inserting at the end adds one leg, elsewhere replaces one
+        int best_pos=len;
+        long best_add=pd(P,t[len-1],pick);
+        for(int k=1;k<len;k++){
+            long add=(long)pd(P,t[k-1],pick)+pd(P,pick,t[k])-pd(P,t[k-1],t[k]);
+            if(add<best_add){ best_add=add; best_pos=k; }
+        }
+        memmove(&t[best_pos+1],&t[best_pos],(size_t)(len-best_pos)*sizeof(int));
+        t[best_pos]=pick;
+        len++;
+        in[pick]=1;
+
+        for(int j=1;j<=n;j++) if(!in[j] && pd(P,pick,j)<near[j]) near[j]=pd(P,pick,j);
+    }
+
+    free(near); free(in);
+}
+
+static void reverse_range(int *t, int i, int j){
+    while(i<j){ int tmp=t[i]; t[i]=t[j]; t[j]=tmp; i++; j--; }
+}
+
+// Rotate t[lo..hi] so that t[mid] comes first.
+static void rotate_range(int *t, int lo, int mid, int hi){
+    reverse_range(t,lo,mid-1);
+    reverse_range(t,mid,hi);
+    reverse_range(t,lo,hi);
+}
+
+static void fill_suffix(const Problem *P, const int *t, double *suf){
+    suf[P->n+1]=0;
+    for(int k=P->n;k>=0;k--) suf[k]=suf[k+1]+P->prio[t[k]];
+}
+
+// 2-opt (segment reversal) and Or-opt (move 1-3 points) on the weighted
+// objective, first improvement, within LS_WINDOW positions.
+static void local_search(const Problem *P, int *t){
+    int n=P->n;
+    double *suf=(double*)malloc((size_t)(n+2)*sizeof(double));
+    if(!suf){ fprintf(stderr,"alloc failed\n"); exit(1); }
+    fill_suffix(P,t,suf);
+
+    for(int pass=0;pass<LS_PASSES;pass++){
+        int improved=0;
+
+        for(int i=1;i<n;i++){
+            for(int j=i+1;j<=n && j<=i+LS_WINDOW;j++){
+                int hi=(j<n)?j+1:n;
+                double before=legs_cost(P,t,i,hi,suf[hi+1]);
+                reverse_range(t,i,j);
+                double after=legs_cost(P,t,i,hi,suf[hi+1]);
+                if(after<before-1e-9){ improved=1; fill_suffix(P,t,suf); }
+                else reverse_range(t,i,j);
+            }
+        }
+
+        for(int L=1;L<=3;L++){
+            for(int i=1;i+L-1<=n;i++){
+                // forward: segment i..i+L-1 goes after position j
+                for(int j=i+L;j<=n && j<=i+L+LS_WINDOW;j++){
+                    int hi=(j<n)?j+1:n;
+                    double before=legs_cost(P,t,i,hi,suf[hi+1]);
+                    rotate_range(t,i,i+L,j);
+                    double after=legs_cost(P,t,i,hi,suf[hi+1]);
+                    if(after<before-1e-9){ improved=1; fill_suffix(P,t,suf); }
+                    else rotate_range(t,i,j-L+1,j);
+                }
+                // backward: segment goes before position p
+                for(int p=i-1;p>=1 && p>=i-LS_WINDOW;p--){
+                    int hi=(i+L<=n)?i+L:n;
+                    double before=legs_cost(P,t,p,hi,suf[hi+1]);
+                    rotate_range(t,p,i,i+L-1);
+                    double after=legs_cost(P,t,p,hi,suf[hi+1]);
+                    if(after<before-1e-9){ improved=1; fill_suffix(P,t,suf); }
+                    else rotate_range(t,p,p+L,i+L-1);
+                }
+            }
+        }
+
+        if(!improved) break;
+    }
+
+    free(suf);
+}
+
+// Append the walk from cell `from` to survivor s, following its parent field.
+static long append_leg(Path *out, int from, int s, const unsigned char *field){
+    int target=coord_index(shared->survivors[s]);
+    int gxy=config.grid_x*config.grid_y;
+    long steps=0;
+    int cur=from;
+    while(cur!=target){
+        int k=field[cur];
+        if(k==NO_PARENT) break;
+        cur+=dirs[k].x + dirs[k].y*config.grid_x + dirs[k].z*gxy;
+        steps++;
+        genome_push(out,k);  // tour's dirs are in genome order; no-op once full
+    }
+    return steps;
+}
+
+int tour_build_baseline(Path *out_path, Coord start, FitnessScratch *sc){
+    int S=config.num_survivors;
+    int N=config.grid_x*config.grid_y*config.grid_z;
+    memset(&stats,0,sizeof(stats));
+
+    genome_reset(out_path,start);
+    if(S==0){ calculate_fitness(out_path, sc); return 1; }
+
+    // ---- distances: one BFS per survivor, in parallel ----
+    double t0=now_ms();
+    BfsJob job;
+    job.S=S;
+    job.start_cell=coord_index(start);
+    job.dist=(int*)malloc((size_t)S*(S+1)*sizeof(int));
+    job.fields=NULL;
+    atomic_init(&job.next,0);
+    if(!job.dist){ fprintf(stderr,"alloc failed\n"); exit(1); }
+
+    if((double)S*(double)N <= (double)config.tour_field_mb*1024.0*1024.0){
+        job.fields=(unsigned char**)malloc((size_t)S*sizeof(unsigned char*));
+        if(!job.fields){ fprintf(stderr,"alloc failed\n"); exit(1); }
+        for(int s=0;s<S;s++){
+            job.fields[s]=(unsigned char*)malloc((size_t)N);
+            if(!job.fields[s]){ fprintf(stderr,"alloc failed\n"); exit(1); }
+        }
+    }
+
+    int T=config.num_processes;
+    if(T>S) T=S;
+    if(T<1) T=1;
+    pthread_t th[T];
+    for(int i=1;i<T;i++) pthread_create(&th[i],NULL,bfs_worker,&job);
+    bfs_worker(&job);
+    for(int i=1;i<T;i++) pthread_join(th[i],NULL);
+    stats.threads=T;
+    stats.fields_kept=(job.fields!=NULL);
+    stats.bfs_ms=now_ms()-t0;
+
+    // ---- visit order over the survivors reachable from the start ----
+    t0=now_ms();
+    int *ids=(int*)malloc((size_t)S*sizeof(int));
+    if(!ids){ fprintf(stderr,"alloc failed\n"); exit(1); }
+    int n=0;
+    for(int s=0;s<S;s++) if(job.dist[s*(S+1)+S]<UNREACHED) ids[n++]=s;
+    stats.reachable=n;
+
+    Problem P;
+    P.n=n;
+    P.w=config.tour_priority_weight;
+    P.D=(int*)malloc((size_t)(n+1)*(n+1)*sizeof(int));
+    P.prio=(double*)malloc((size_t)(n+1)*sizeof(double));
+    int *t=(int*)malloc((size_t)(n+1)*sizeof(int));
+    if(!P.D||!P.prio||!t){ fprintf(stderr,"alloc failed\n"); exit(1); }
+
+    // distances are symmetric; column S of each BFS row holds the start
+    P.prio[0]=0; P.total=0;
+    for(int a=0;a<=n;a++){
+        for(int b=0;b<=n;b++){
+            int v;
+            if(a==b)      v=0;
+            else if(a==0) v=job.dist[ids[b-1]*(S+1)+S];
+            else if(b==0) v=job.dist[ids[a-1]*(S+1)+S];
+            else          v=job.dist[ids[a-1]*(S+1)+ids[b-1]];
+            P.D[a*(n+1)+b]=v;
+        }
+        if(a>0){ P.prio[a]=shared->survivor_priority[ids[a-1]]; P.total+=P.prio[a]; }
+    }
+
+    if(n>0){
+        if(n<=config.tour_exact_limit){
+            held_karp(&P,t);
+            stats.exact=1;
+        } else {
+            nearest_insertion(&P,t);
+            local_search(&P,t);
+        }
+        stats.cost=tour_cost(&P,t);
+    }
+    stats.solve_ms=now_ms()-t0;
+
+    // ---- legs straight from the parent fields ----
+    int *d=NULL, *queue=NULL;
+    unsigned char *field=NULL;
+    if(!job.fields){
+        // fields did not fit: one more BFS per leg destination
+        d=(int*)malloc((size_t)N*sizeof(int));
+        queue=(int*)malloc((size_t)N*sizeof(int));
+        field=(unsigned char*)malloc((size_t)N);
+        if(!d||!queue||!field){ fprintf(stderr,"alloc failed\n"); exit(1); }
+    }
+
+    int cur=coord_index(start);
+    for(int k=1;k<=n;k++){
+        int s=ids[t[k]-1];
+        const unsigned char *f;
+        if(job.fields) f=job.fields[s];
+        else { bfs(coord_index(shared->survivors[s]),d,queue,field); f=field; }
+        stats.total_steps+=append_leg(out_path,cur,s,f);
+        cur=coord_index(shared->survivors[s]);
+    }
+
+    free(d); free(queue); free(field);
+    if(job.fields){ for(int s=0;s<S;s++) free(job.fields[s]); free(job.fields); }
+    free(job.dist); free(ids); free(P.D); free(P.prio); free(t);
+
+    out_path->ckpt_count=0;
+    calculate_fitness(out_path, sc);
+    return (out_path->length>0);
+}
+
+void tour_get_stats(TourStats *out){
+    *out=stats;
+}
@@ -0,0 +1,26 @@
+#ifndef TOUR_H
+#define TOUR_H
+
+#include "types.h"
+#include "genetic.h"
+
+// Baseline that orders survivors by travel cost instead of by priority:
+// one BFS per survivor (run in parallel) gives an exact distance matrix,
+// the visit order is solved on it, and legs are read back from the BFS
+// parent fields without any further search.
+int tour_build_baseline(Path *out_path, Coord start, FitnessScratch *s);
+
+typedef struct {
+    int    reachable;       // survivors reachable from the start
+    int    exact;           // 1 = Held-Karp, 0 = insertion + 2-opt/Or-opt
+    int    threads;
+    int    fields_kept;     // parent fields fit in tour_field_mb
+    double bfs_ms;
+    double solve_ms;
+    double cost;            // priority-weighted objective of the chosen order
+    long   total_steps;     // sum of leg lengths before path truncation
+} TourStats;
+
+void tour_get_stats(TourStats *out);
+
+#endif
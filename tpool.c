@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sched.h>
+
+#include "tpool.h"
+#include "pool.h"
+#include "config.h"
+#include "genetic.h"
+#include "genome.h"
+#include "rng.h"
+#include "telemetry.h"
+
+#define TASK_EMPTY -1
+#define TASK_ABORT -2
+
+// Chase-Lev work-stealing deque (the C11 formulation of Le et al.). The
+// owner pushes and pops at the bottom, thieves take from the top. The ring
+// is never resized: a generation never queues more than num_tasks.
+typedef struct {
+    atomic_long top;
+    char        pad0[64 - sizeof(atomic_long)];
+    atomic_long bottom;
+    char        pad1[64 - sizeof(atomic_long)];
+    atomic_int *buf;
+    long        mask;
+} Deque;
+
+static void dq_push(Deque *d, int x) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    atomic_store_explicit(&d->buf[b & d->mask], x, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+}
+
+static int dq_pop(Deque *d) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (t > b) {  // empty
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return TASK_EMPTY;
+    }
+    int x = atomic_load_explicit(&d->buf[b & d->mask], memory_order_relaxed);
+    if (t == b) {
+        // last entry: race the thieves for it
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                     memory_order_seq_cst, memory_order_relaxed))
+            x = TASK_EMPTY;
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return x;
+}
+
+static int dq_steal(Deque *d) {
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (t >= b) return TASK_EMPTY;
+    int x = atomic_load_explicit(&d->buf[t & d->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed))
+        return TASK_ABORT;
+    return x;
+}
+
+typedef struct {
+    int            id;
+    pthread_t      th;
+    Deque          dq;
+    FitnessScratch scratch;
+    double         wait_ms;
+    long           tasks;
+    long           stolen;
+} TWorker;
+
+static TWorker *tw;
+static int      T;
+static Path    *cur, *next;       // cur starts as shared->population
+static int      N, elite, num_tasks;
+static int      gen_local;        // generation being bred, from 1
+static int      done;
+static atomic_int remaining;      // tasks of this generation not finished yet
+static pthread_barrier_t bar;
+
+static TPoolStats stats;
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static void timed_barrier(TWorker *w) {
+    double t0 = now_ms();
+    pthread_barrier_wait(&bar);
+    w->wait_ms += now_ms() - t0;
+}
+
+// Thread 0, while the others wait in the barrier: retire the generation
+// just bred, then set up the next one.
+static void prepare_generation(void) {
+    if (gen_local > 0) {
+        Path *t = cur; cur = next; next = t;
+
+        int b = 0;
+        for (int i = 1; i < N; i++)
+            if (cur[i].fitness > cur[b].fitness) b = i;
+        pool_publish_best(&cur[b], 0);
+
+        // one record per generation: the others are parked, so their
+        // counters hold still while they are summed
+        if (telemetry_on()) {
+            FitnessScratch sum = tw[0].scratch;
+            for (int i = 1; i < T; i++) {
+                sum.evaluated    += tw[i].scratch.evaluated;
+                sum.skipped      += tw[i].scratch.skipped;
+                sum.cache.hits   += tw[i].scratch.cache.hits;
+                sum.cache.misses += tw[i].scratch.cache.misses;
+            }
+            telemetry_emit(0, gen_local, cur, N, &sum, tw[0].wait_ms);
+        }
+
+        if (gen_local % GENS_PER_BARRIER == 0) {
+            atomic_fetch_add(&shared->generation, 1);
+            pool_notify();
+        }
+    }
+
+    if (atomic_load(&shared->stop_flag) ||
+        atomic_load(&shared->generation) >= config.num_generations) {
+        done = 1;
+        return;
+    }
+
+    elite = select_elites(cur, N, next);
+    num_tasks = (N - elite + TPOOL_CHUNK - 1) / TPOOL_CHUNK;
+    atomic_store(&remaining, num_tasks);
+    gen_local++;
+}
+
+static void run_task(TWorker *w, int c) {
+    int from = elite + c * TPOOL_CHUNK;
+    int to = from + TPOOL_CHUNK;
+    if (to > N) to = N;
+
+    // streams 0..num_processes belong to main and the fork workers
+    Rng r;
+    rng_seed(&r, config.seed, ((unsigned long long)gen_local << 32) | (unsigned)c);
+    breed_children(cur, N, next, from, to, &w->scratch, &r);
+    w->tasks++;
+}
+
+static void *tworker_main(void *arg) {
+    TWorker *w = (TWorker *)arg;
+
+    // picks victims only, so it needs no tie to the seed
+    Rng victims;
+    rng_seed(&victims, (unsigned long long)(size_t)w, (unsigned long long)w->id);
+
+    while (1) {
+        if (w->id == 0) prepare_generation();
+        timed_barrier(w);
+        if (done) break;
+
+        for (int c = w->id; c < num_tasks; c += T) dq_push(&w->dq, c);
+
+        int misses = 0;
+        while (atomic_load_explicit(&remaining, memory_order_acquire) > 0) {
+            int c = dq_pop(&w->dq);
+            if (c < 0 && T > 1) {
+                int v = rng_below(&victims, T - 1);
+                if (v >= w->id) v++;
+                c = dq_steal(&tw[v].dq);
+                if (c >= 0) w->stolen++;
+            }
+            if (c >= 0) {
+                run_task(w, c);
+                atomic_fetch_sub_explicit(&remaining, 1, memory_order_release);
+                misses = 0;
+            } else if (++misses < 64) {
+                cpu_relax();
+            } else {
+                sched_yield();  // more threads than cores: let the busy ones run
+            }
+        }
+        timed_barrier(w);
+    }
+    return NULL;
+}
+
+void tpool_start(void) {
+    T = config.num_processes;
+    N = config.population_size;
+    cur = shared->population;
+    next = genome_alloc(N, config.max_path_length);
+    gen_local = 0;
+    done = 0;
+    shared->ga_start_ms = now_ms();
+
+    long cap = 1;
+    while (cap < (N + TPOOL_CHUNK - 1) / TPOOL_CHUNK) cap <<= 1;
+
+    tw = (TWorker *)calloc((size_t)T, sizeof(TWorker));
+    if (!tw) { fprintf(stderr, "alloc failed\n"); exit(1); }
+    pthread_barrier_init(&bar, NULL, (unsigned)T);
+
+    for (int i = 0; i < T; i++) {
+        TWorker *w = &tw[i];
+        w->id = i;
+        w->dq.buf = (atomic_int *)malloc((size_t)cap * sizeof(atomic_int));
+        if (!w->dq.buf) { fprintf(stderr, "alloc failed\n"); exit(1); }
+        w->dq.mask = cap - 1;
+        atomic_init(&w->dq.top, 0);
+        atomic_init(&w->dq.bottom, 0);
+        scratch_init(&w->scratch);
+    }
+    for (int i = 0; i < T; i++)
+        if (pthread_create(&tw[i].th, NULL, tworker_main, &tw[i]) != 0) {
+            fprintf(stderr, "worker thread failed\n");
+            exit(1);
+        }
+}
+
+void tpool_join(void) {
+    memset(&stats, 0, sizeof(stats));
+    for (int i = 0; i < T; i++) {
+        TWorker *w = &tw[i];
+        pthread_join(w->th, NULL);
+        shared->wait_ms[i]     = w->wait_ms;
+        shared->evals         += w->scratch.evaluated;
+        shared->evals_skipped += w->scratch.skipped;
+        shared->cache_hits    += w->scratch.cache.hits;
+        shared->cache_misses  += w->scratch.cache.misses;
+        stats.tasks  += w->tasks;
+        stats.stolen += w->stolen;
+        scratch_free(&w->scratch);
+        free(w->dq.buf);
+    }
+    stats.generations = gen_local;
+
+    // leave the final generation in shared->population
+    if (cur != shared->population) {
+        for (int i = 0; i < N; i++) genome_copy(&shared->population[i], &cur[i]);
+        next = cur;
+    }
+    free(next);
+    pthread_barrier_destroy(&bar);
+    free(tw);
+    tw = NULL;
+}
+
+void tpool_get_stats(TPoolStats *out) {
+    *out = stats;
+}
@@ -0,0 +1,24 @@
+#ifndef TPOOL_H
+#define TPOOL_H
+
+// backend=threads: num_processes threads evolve shared->population as one
+// population. Each generation thread 0 copies the elites, then the
+// children are cut into TPOOL_CHUNK-sized tasks that the threads breed and
+// evaluate through per-thread work-stealing deques, so threads that draw
+// short paths take work from those that draw long ones. A task's random
+// stream depends only on (seed, generation, task), so results do not
+// depend on which thread ran it.
+#define TPOOL_CHUNK 8
+
+void tpool_start(void);
+void tpool_join(void);
+
+typedef struct {
+    int  generations;   // bred over the whole population
+    long tasks;         // chunks run
+    long stolen;        // of those, taken from another thread's deque
+} TPoolStats;
+
+void tpool_get_stats(TPoolStats *out);
+
+#endif
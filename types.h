@@ -1,7 +1,14 @@
 #ifndef TYPES_H
 #define TYPES_H
 
-#define MAX_PATH_LENGTH 500
+#include <stdatomic.h>
+
+// Cells kept in the A*/tour baseline path when max_path_length is shorter.
+#define BASELINE_PATH_LENGTH 500
+
+// calculate_fitness records its running totals every FITNESS_CKPT_STRIDE
+// genes so children can be re-evaluated from the first changed gene.
+#define FITNESS_CKPT_STRIDE 32
 
 #define EMPTY    0
 #define OBSTACLE 1
@@ -12,30 +19,74 @@ typedef struct {
 } Coord;
 
 typedef struct {
-    Coord  genes[MAX_PATH_LENGTH];
-    int    length;
+    int risk;
+    int coverage;
+    int survivors;
+    int priority;
+    Coord last;   // cell k*FITNESS_CKPT_STRIDE-1, where evaluation resumes
+} FitnessCkpt; // totals over genes [0, k*FITNESS_CKPT_STRIDE)
+
+// Genes are direction-encoded, see genome.h.
+typedef struct {
+    Coord  start;
+    int    length;   // cells, including start
+    int    cap;      // cells the storage holds
+    unsigned long long *moves;
     double fitness;
 
     int survivors_reached; // unique
     int priority_sum;      // unique sum of priorities reached
     int coverage;          // unique visited cells
+
+    int          ckpt_count;  // valid entries in ckpt
+    FitnessCkpt *ckpt;
 } Path;
 
 typedef struct {
     Path  *population;
-    int   *grid;
+
+    // occupancy, see grid.h
+    int    chunked;                // grid_storage=chunked
+    unsigned char *cells;          // dense: 2 bits per cell
+    unsigned char *obstacle_bits;  // dense: 1 bit per cell, guard-padded rows
+    int   *chunk_dir;              // chunked: brick per 16^3 chunk, -1 = all EMPTY
+    unsigned char *bricks;         // chunked: brick pool
+    int    bricks_used;
+    int   *survivor_table;         // (cell, survivor index) pairs
 
     Coord *survivors;
     int   *survivor_priority;
 
     Coord *obstacles;
 
-    int generation;
-    int workers_done;
-    int stop_flag;
+    int    total_priority;      // sum over survivors, set by init_grid
+
+    // control words, read without the semaphore (see pool.c)
+    atomic_int  generation;
+    atomic_int  workers_done;   // arrivals at the current barrier
+    atomic_int  stop_flag;
+    atomic_uint barrier_seq;    // futex word, bumped to release a barrier
+    double     *wait_ms;        // per worker: time spent in the barrier
+    atomic_uint event_seq;      // futex word the supervisor sleeps on, bumped by pool_notify
+    double      event_ms;       // CLOCK_MONOTONIC of the latest bump
+    atomic_long evaluations;    // ga_mode=steady: children bred, GENS_PER_BARRIER x population_size per generation
 
+    double ga_start_ms;         // CLOCK_MONOTONIC when the workers started
+    double target_ms;           // first publish at or above target_fitness, -1 = not yet
+    int    target_gen;
+
+    atomic_uint best_seq;       // seqlock over the three best_* fields, see pool.c
     double best_fitness;
-    Path   best_path;
+    int    best_worker;         // who published best_path, -1 = main; ties go to the lowest
+    Path   best_path;           // storage follows the population's
+
+    // fitness evaluation counters, summed over workers as they exit
+    long evals;
+    long evals_skipped;
+    long cache_hits;
+    long cache_misses;
+    long steady_inserted;   // ga_mode=steady: children that replaced a member
+    long worker_rss_kb;     // largest peak RSS among worker processes
 } SharedData;
 
 #endif
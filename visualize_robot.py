@@ -13,6 +13,56 @@ def numeric_sort(files, prefix):
     files.sort(key=lambda f: extract_num(f, prefix))
     return files
 
+# Binary snapshot log (snapshot_format=binary), layout in snapshot_log.h.
+SNAP_FILE = "robot_data.snap"
+SNAP_MAGIC = b"RBSNAP01"
+SNAP_HDR = np.dtype([('magic','S8'),('version','<u4'),('header_bytes','<u4'),('grid','<i4',(3,)),
+                     ('num_survivors','<i4'),('num_obstacles','<i4'),('moves_per_word','<i4')])
+SNAP_REC = np.dtype([('record_bytes','<u4'),('snapshot','<i4'),('gen','<i4'),('length','<i4'),
+                     ('fitness','<f8'),('start','<i4',(3,)),('words','<i4')])
+MOVE_DIRS = np.array([[1,0,0],[-1,0,0],[0,1,0],[0,-1,0],[0,0,1],[0,0,-1]], dtype=np.int32)
+
+class SnapLog:
+    """Memory-mapped robot_data.snap; records are views into the map, paths
+    are decoded only when asked for."""
+    def __init__(self, filename=SNAP_FILE):
+        self.mm = np.memmap(filename, dtype=np.uint8, mode='r')
+        self.hdr = self.mm[:SNAP_HDR.itemsize].view(SNAP_HDR)[0]
+        if self.hdr['magic'] != SNAP_MAGIC:
+            raise ValueError(f"{filename}: not a snapshot log")
+        ns, no = int(self.hdr['num_survivors']), int(self.hdr['num_obstacles'])
+        off = SNAP_HDR.itemsize
+        self.survivors = self.mm[off:off+16*ns].view('<i4').reshape(ns,4)
+        off += 16*ns
+        self.obstacles = self.mm[off:off+12*no].view('<i4').reshape(no,3)
+
+        # walk the length prefixes; a short tail is a record still being written
+        offsets=[]; off=int(self.hdr['header_bytes']); end=len(self.mm)
+        while off+SNAP_REC.itemsize <= end:
+            n=int(self.mm[off:off+4].view('<u4')[0])
+            if n < SNAP_REC.itemsize or off+n > end: break
+            offsets.append(off); off+=n
+        self.offsets=offsets
+
+    def __len__(self):
+        return len(self.offsets)
+
+    def record(self, i):
+        o=self.offsets[i]
+        return self.mm[o:o+SNAP_REC.itemsize].view(SNAP_REC)[0]
+
+    def fitness(self):
+        return np.array([self.record(i)['fitness'] for i in range(len(self))])
+
+    def path(self, i):
+        r=self.record(i)
+        o=self.offsets[i]+SNAP_REC.itemsize
+        words=self.mm[o:o+8*int(r['words'])].view('<u8')
+        shifts=np.arange(int(self.hdr['moves_per_word']), dtype=np.uint64)*np.uint64(3)
+        moves=((words[:,None] >> shifts) & np.uint64(7)).ravel()[:int(r['length'])-1]
+        start=np.asarray(r['start'], dtype=np.int32)
+        return np.vstack([start, start+np.cumsum(MOVE_DIRS[moves], axis=0)])
+
 class RescueVisualizer:
     def __init__(self):
         self.grid_x=self.grid_y=self.grid_z=0
@@ -65,6 +115,14 @@ class RescueVisualizer:
             print(f"Error parsing {filename}: {e}")
             return False
 
+    def load_snap(self, log, i):
+        r=log.record(i)
+        self.grid_x, self.grid_y, self.grid_z = (int(v) for v in log.hdr['grid'])
+        self.gen=int(r['gen']); self.fitness=float(r['fitness'])
+        self.survivors=log.survivors[:,:3].tolist(); self.survivor_p=log.survivors[:,3].tolist()
+        self.obstacles=log.obstacles.tolist()
+        self.path=log.path(i).tolist()
+
     def visualize_single(self, ax, title):
         if self.survivors:
             S=np.array(self.survivors)
@@ -101,14 +159,31 @@ def main():
     astar_file = "robot_data_astar.txt"
     has_astar = (astar_file in glob.glob("robot_data_astar.txt"))
 
-    print(f"Found snapshots: {len(global_files)} | workers: {len(worker_files)} | astar: {has_astar}")
+    log = SnapLog() if glob.glob(SNAP_FILE) else None
+    print(f"Found snapshots: {len(global_files)} | workers: {len(worker_files)} | astar: {has_astar}"
+          + (f" | {SNAP_FILE}: {len(log)} records" if log is not None else ""))
 
     vis=RescueVisualizer()
 
     print("\n1) Evolution grid (snapshots)\n2) Fitness chart\n3) Show A* baseline only\n4) Show single file")
     ch=input("Choice: ").strip()
 
-    if ch=="1":
+    if ch=="1" and log is not None and len(log):
+        # at most 8 panels, spread evenly over the log
+        picks=sorted(set(np.linspace(0, len(log)-1, min(len(log),8)).astype(int).tolist()))
+        n=len(picks)
+        rows=2 if n>=4 else 1
+        cols=(n+1)//2 if n>=4 else n
+        fig=plt.figure(figsize=(18,10))
+        for idx,i in enumerate(picks):
+            vis.load_snap(log, i)
+            ax=fig.add_subplot(rows,cols,idx+1,projection="3d")
+            vis.visualize_single(ax, f"Snapshot {int(log.record(i)['snapshot'])}/{len(log)}")
+        plt.suptitle("GA Evolution (Snapshots)", fontsize=14, fontweight="bold")
+        plt.tight_layout(rect=[0,0,1,0.96])
+        plt.show()
+
+    elif ch=="1":
         if not global_files:
             print("No robot_data_*.txt found"); return
         n=len(global_files)
@@ -124,6 +199,14 @@ def main():
         plt.tight_layout(rect=[0,0,1,0.96])
         plt.show()
 
+    elif ch=="2" and log is not None and len(log):
+        xs=[int(log.record(i)['snapshot']) for i in range(len(log))]
+        plt.figure(figsize=(10,6))
+        plt.plot(xs,log.fitness(),'o-', linewidth=2)
+        plt.xlabel("Snapshot #"); plt.ylabel("Fitness"); plt.title("Fitness Evolution")
+        plt.grid(True, alpha=0.3)
+        plt.show()
+
     elif ch=="2":
         if not global_files:
             print("No robot_data_*.txt found"); return
@@ -151,9 +234,17 @@ def main():
 
     elif ch=="4":
         files = list(global_files) + worker_files + ([astar_file] if has_astar else [])
+        nlog = len(log) if log is not None else 0
         for i,f in enumerate(files): print(f"{i+1}. {f}")
+        if nlog: print(f"{len(files)+1}-{len(files)+nlog}. {SNAP_FILE} records 1-{nlog}")
         k=int(input("File #: "))-1
-        if 0<=k<len(files) and vis.parse_data_file(files[k]):
+        if len(files)<=k<len(files)+nlog:
+            vis.load_snap(log, k-len(files))
+            fig=plt.figure(figsize=(12,9))
+            ax=fig.add_subplot(111,projection="3d")
+            vis.visualize_single(ax, f"{SNAP_FILE} record {k-len(files)+1}")
+            plt.show()
+        elif 0<=k<len(files) and vis.parse_data_file(files[k]):
             fig=plt.figure(figsize=(12,9))
             ax=fig.add_subplot(111,projection="3d")
             vis.visualize_single(ax, files[k])